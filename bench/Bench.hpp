@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstddef>
+
+/**
+ * @brief Minimal timing harness shared by the micro benchmarks in bench/.
+ * Only depends on the standard library, so a benchmark also builds against older trees.
+ */
+namespace bench
+{
+	/**
+	 * @brief Keeps the compiler from dropping a result nothing else reads.
+	 */
+	template <typename Value>
+	inline void	keep( const Value& value )
+	{
+		asm volatile( "" : : "r,m"( value ) : "memory" );
+	}
+
+	/**
+	 * @brief Runs body iterations times after a warm up and prints the time per unit and the rate.
+	 * @param unit What one iteration processes, printed after the time.
+	 * @param perIteration How many units one iteration processes, the time is divided by it.
+	 */
+	template <typename Body>
+	void	run( const char* name, size_t iterations, Body&& body, const char* unit = "op", size_t perIteration = 1 )
+	{
+		for ( size_t idx = 0; idx < iterations / 10 + 1; ++idx )
+			body();
+
+		auto	start = std::chrono::steady_clock::now();
+		for ( size_t idx = 0; idx < iterations; ++idx )
+			body();
+		std::chrono::duration<double, std::nano>	elapsed = std::chrono::steady_clock::now() - start;
+
+		double	perUnit = elapsed.count() / ( static_cast<double>( iterations ) * perIteration );
+		std::printf( "%-32s %10.3f ns/%-4s %10.1f M%s/s\n", name, perUnit, unit, 1e3 / perUnit, unit );
+	}
+}
@@ -0,0 +1,58 @@
+#include <unordered_set>
+#include <vector>
+#include "Bench.hpp"
+#include "Channels.hpp"
+#include "ClientTable.hpp"
+
+/**
+ * @brief Walks a 20k member channel as fan-out and NAMES do: every member's client is looked up
+ * and its operator status read. Compared with the member and operator sets the channel used before.
+ */
+int	main()
+{
+	constexpr int	members	= 20000;
+	constexpr int	firstFd	= 5;
+
+	ClientTable						table;
+	Channel							channel( "#bench", 0 );
+	std::unordered_set<int>			memberSet;
+	std::unordered_set<int>			operatorSet;
+	std::vector<ClientHandle>		handles;
+
+	for ( int fd = firstFd; fd < firstFd + members; ++fd )
+	{
+		table.emplace( fd );
+		handles.push_back( table.handle( fd ) );
+		channel.addMember( handles.back() );
+		memberSet.insert( fd );
+		if ( fd % 10 == 0 )
+		{
+			channel.addOperator( handles.back() );
+			operatorSet.insert( fd );
+		}
+	}
+
+	bench::run( "Channel member array walk", 200, [&]() {
+		for ( const Channel::Member& member : channel.getMembers() )
+		{
+			bench::keep( table.find( member.client ) );
+			bench::keep( member.isOperator() );
+		}
+	}, "member", members );
+	bench::run( "member and operator sets walk", 200, [&]() {
+		for ( int fd : memberSet )
+		{
+			bench::keep( table.find( fd ) );
+			bench::keep( operatorSet.count( fd ) );
+		}
+	}, "member", members );
+	bench::run( "Channel::isMember", 200, [&]() {
+		for ( ClientHandle handle : handles )
+			bench::keep( channel.isMember( handle ) );
+	}, "op", members );
+	bench::run( "member set lookup", 200, [&]() {
+		for ( int fd = firstFd; fd < firstFd + members; ++fd )
+			bench::keep( memberSet.count( fd ) );
+	}, "op", members );
+	return ( 0 );
+}
@@ -0,0 +1,56 @@
+#!/usr/bin/env python3
+"""
+Connection churn allocation benchmark.
+
+Runs CYCLES cycles of connect, register, JOIN, PRIVMSG, QUIT and close,
+one client at a time, and reports the heap allocations the server made
+per cycle. The server must run with build/counters.so preloaded.
+A first round of cycles warms the server up and is not counted, so the
+result is what a steady stream of short connections costs.
+
+Usage: bench/churn.py PORT SERVER_PID [CYCLES] [PASSWORD]
+"""
+
+import os
+import socket
+import struct
+import sys
+import time
+
+PORT		= int(sys.argv[1])
+SERVER_PID	= int(sys.argv[2])
+CYCLES		= int(sys.argv[3]) if len(sys.argv) > 3 else 1000
+PASSWORD	= sys.argv[4] if len(sys.argv) > 4 else "pass"
+COUNTERS	= os.environ.get("IRCSERV_COUNTERS", "/tmp/ircserv.counters")
+CHANNELS	= 50
+
+def	allocations():
+	with open(COUNTERS, "rb") as counters:
+		return struct.unpack("QQ", counters.read(16))[1]
+
+def	cycle(index):
+	channel = f"#churn{index % CHANNELS}"
+	sock = socket.create_connection(("127.0.0.1", PORT))
+	sock.sendall(f"PASS {PASSWORD}\r\nNICK c{index}\r\nUSER c{index} 0 * :c{index}\r\n"
+		f"JOIN {channel}\r\nPRIVMSG {channel} :hello\r\nQUIT :bye\r\n".encode())
+	sock.settimeout(5)
+	try:
+		while sock.recv(65536):
+			pass
+	except OSError:
+		pass
+	sock.close()
+
+with open(f"/proc/{SERVER_PID}/maps") as maps:
+	if "counters.so" not in maps.read():
+		sys.exit("the server does not have build/counters.so preloaded")
+
+for index in range(CYCLES // 5 + CHANNELS):
+	cycle(index)
+time.sleep(0.2)
+before = allocations()
+for index in range(CYCLES):
+	cycle(index)
+time.sleep(0.2)
+
+print(f"{CYCLES} cycles, {(allocations() - before) / CYCLES:.1f} server allocations per cycle")
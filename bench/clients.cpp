@@ -0,0 +1,45 @@
+#include <algorithm>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include "Bench.hpp"
+#include "ClientTable.hpp"
+
+/**
+ * @brief Client lookups by descriptor over 30k connected clients, in a random order, compared
+ * with the unordered_map<int, Client> the server used before ClientTable.
+ */
+int	main()
+{
+	constexpr int	clients		= 30000;
+	constexpr int	firstFd		= 5;
+
+	ClientTable							table;
+	std::unordered_map<int, Client>		map;
+	std::vector<int>					order;
+	std::vector<ClientHandle>			handles;
+
+	for ( int fd = firstFd; fd < firstFd + clients; ++fd )
+	{
+		table.emplace( fd );
+		map.try_emplace( fd );
+		order.push_back( fd );
+	}
+	std::shuffle( order.begin(), order.end(), std::mt19937( 42 ) );
+	for ( int fd : order )
+		handles.push_back( table.handle( fd ) );
+
+	bench::run( "ClientTable::find(fd)", 200, [&]() {
+		for ( int fd : order )
+			bench::keep( table.find( fd ) );
+	}, "op", order.size() );
+	bench::run( "ClientTable::find(handle)", 200, [&]() {
+		for ( ClientHandle handle : handles )
+			bench::keep( table.find( handle ) );
+	}, "op", handles.size() );
+	bench::run( "unordered_map::find(fd)", 200, [&]() {
+		for ( int fd : order )
+			bench::keep( &map.find( fd )->second );
+	}, "op", order.size() );
+	return ( 0 );
+}
@@ -0,0 +1,137 @@
+/**
+ * @brief Counters preloaded into the server by the benchmarks.
+ *
+ * Built as build/counters.so and loaded with LD_PRELOAD. Every call the server makes to write
+ * to a socket, and every heap allocation, is counted into a small file mapped shared,
+ * IRCSERV_COUNTERS or /tmp/ircserv.counters, so a benchmark reads the counts while the server runs.
+ * The io_uring backend sends without going through these calls, its sends are not counted.
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+extern "C" void*	__libc_malloc	( size_t size );
+extern "C" void*	__libc_calloc	( size_t count, size_t size );
+extern "C" void*	__libc_realloc	( void* pointer, size_t size );
+extern "C" void*	__libc_memalign	( size_t alignment, size_t size );
+
+namespace
+{
+	struct Counters
+	{
+		std::atomic<uint64_t>	socketWrites;
+		std::atomic<uint64_t>	allocations;
+	};
+
+	Counters	fallback;
+	Counters*	counters = &fallback;
+
+	template <typename Function>
+	Function	next( const char* name )
+	{
+		return ( reinterpret_cast<Function>( dlsym( RTLD_NEXT, name ) ) );
+	}
+
+	__attribute__((constructor))
+	void	mapCounters()
+	{
+		const char*	path	= getenv( "IRCSERV_COUNTERS" );
+		int			fd		= open( path ? path : "/tmp/ircserv.counters", O_RDWR | O_CREAT | O_TRUNC, 0644 );
+
+		if ( fd < 0 )
+			return ;
+		if ( ftruncate( fd, sizeof( Counters ) ) == 0 )
+		{
+			void* mapped = mmap( nullptr, sizeof( Counters ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+			if ( mapped != MAP_FAILED )
+				counters = new ( mapped ) Counters{};
+		}
+		close( fd );
+	}
+
+	void	countSocketWrite()
+	{
+		counters->socketWrites.fetch_add( 1, std::memory_order_relaxed );
+	}
+
+	void	countAllocation()
+	{
+		counters->allocations.fetch_add( 1, std::memory_order_relaxed );
+	}
+}
+
+/// Socket writes
+
+extern "C" ssize_t	send( int fd, const void* buffer, size_t length, int flags )
+{
+	static auto	real = next<ssize_t (*)( int, const void*, size_t, int )>( "send" );
+
+	countSocketWrite();
+	return ( real( fd, buffer, length, flags ) );
+}
+
+extern "C" ssize_t	sendto( int fd, const void* buffer, size_t length, int flags, const sockaddr* address, socklen_t addressLength )
+{
+	static auto	real = next<ssize_t (*)( int, const void*, size_t, int, const sockaddr*, socklen_t )>( "sendto" );
+
+	countSocketWrite();
+	return ( real( fd, buffer, length, flags, address, addressLength ) );
+}
+
+extern "C" ssize_t	sendmsg( int fd, const msghdr* message, int flags )
+{
+	static auto	real = next<ssize_t (*)( int, const msghdr*, int )>( "sendmsg" );
+
+	countSocketWrite();
+	return ( real( fd, message, flags ) );
+}
+
+extern "C" ssize_t	writev( int fd, const iovec* vectors, int count )
+{
+	static auto	real = next<ssize_t (*)( int, const iovec*, int )>( "writev" );
+
+	countSocketWrite();
+	return ( real( fd, vectors, count ) );
+}
+
+/// Heap allocations, operator new allocates through these as well
+
+extern "C" void*	malloc( size_t size )
+{
+	countAllocation();
+	return ( __libc_malloc( size ) );
+}
+
+extern "C" void*	calloc( size_t count, size_t size )
+{
+	countAllocation();
+	return ( __libc_calloc( count, size ) );
+}
+
+extern "C" void*	realloc( void* pointer, size_t size )
+{
+	countAllocation();
+	return ( __libc_realloc( pointer, size ) );
+}
+
+extern "C" void*	aligned_alloc( size_t alignment, size_t size )
+{
+	countAllocation();
+	return ( __libc_memalign( alignment, size ) );
+}
+
+extern "C" int	posix_memalign( void** pointer, size_t alignment, size_t size )
+{
+	countAllocation();
+	*pointer = __libc_memalign( alignment, size );
+	return ( *pointer ? 0 : ENOMEM );
+}
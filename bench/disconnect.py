@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+Mass disconnect benchmark.
+
+Registers N clients, stops the server, closes every client and lets the
+server continue, so all the disconnects are pending at once, as after a
+netsplit. It then reports how long the server took to close them all,
+watching its open descriptors, and the CPU time it spent doing so.
+
+Usage: bench/disconnect.py PORT SERVER_PID [CLIENTS] [PASSWORD]
+The server needs a descriptor limit above CLIENTS, and so does this script.
+"""
+
+import os
+import resource
+import selectors
+import signal
+import socket
+import sys
+import time
+
+PORT		= int(sys.argv[1])
+SERVER_PID	= int(sys.argv[2])
+CLIENTS		= int(sys.argv[3]) if len(sys.argv) > 3 else 50000
+PASSWORD	= sys.argv[4] if len(sys.argv) > 4 else "pass"
+
+def	raise_fd_limit(needed):
+	soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+	if soft < needed:
+		resource.setrlimit(resource.RLIMIT_NOFILE, (min(needed, hard), hard))
+
+def	open_fds():
+	return len(os.listdir(f"/proc/{SERVER_PID}/fd"))
+
+def	cpu_seconds():
+	"""Run time of every server thread, from the scheduler's nanosecond counters."""
+	total = 0
+	for task in os.listdir(f"/proc/{SERVER_PID}/task"):
+		try:
+			with open(f"/proc/{SERVER_PID}/task/{task}/schedstat") as schedstat:
+				total += int(schedstat.read().split()[0])
+		except OSError:
+			pass
+	return total / 1e9
+
+def	wait_stopped():
+	while True:
+		with open(f"/proc/{SERVER_PID}/stat") as stat:
+			if stat.read().rsplit(")", 1)[1].split()[0] == "T":
+				return
+		time.sleep(0.001)
+
+def	register(nick):
+	sock = socket.create_connection(("127.0.0.1", PORT))
+	sock.sendall(f"PASS {PASSWORD}\r\nNICK {nick}\r\nUSER {nick} 0 * :{nick}\r\n".encode())
+	sock.setblocking(False)
+	return sock
+
+def	wait_welcome(socks):
+	selector = selectors.DefaultSelector()
+	pending = {}
+	for sock in socks:
+		selector.register(sock, selectors.EVENT_READ)
+		pending[sock] = b""
+	deadline = time.time() + 60
+	while pending and time.time() < deadline:
+		for key, _ in selector.select(1):
+			data = pending[key.fileobj] + key.fileobj.recv(65536)
+			if b" 001 " in data:
+				selector.unregister(key.fileobj)
+				del pending[key.fileobj]
+			else:
+				pending[key.fileobj] = data
+	selector.close()
+	if pending:
+		sys.exit(f"{len(pending)} of {len(socks)} clients were not welcomed")
+
+raise_fd_limit(CLIENTS + 64)
+baseline = open_fds()
+clients = [register(f"c{i}") for i in range(CLIENTS)]
+wait_welcome(clients)
+
+os.kill(SERVER_PID, signal.SIGSTOP)
+wait_stopped()
+for sock in clients:
+	sock.close()
+cpu = cpu_seconds()
+start = time.perf_counter()
+os.kill(SERVER_PID, signal.SIGCONT)
+
+deadline = start + 120
+while open_fds() > baseline:
+	if time.perf_counter() > deadline:
+		sys.exit(f"{open_fds() - baseline} clients were still open after 120 s")
+	time.sleep(0.002)
+
+print(f"{CLIENTS} pending disconnects closed in {(time.perf_counter() - start) * 1000:.1f} ms, "
+	f"{(cpu_seconds() - cpu) * 1000:.1f} ms of server CPU")
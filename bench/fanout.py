@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+"""
+Channel fan-out benchmark.
+
+Joins MEMBERS clients to one channel. The first one, its operator, then
+sends LINES PRIVMSGs, or TOPIC changes, in a single burst. The script
+waits until every other member has received every line, then reports
+the wall time and the server CPU time, in total and per delivered line.
+When the server runs with build/counters.so preloaded it also reports
+the socket writes the server made per delivered line.
+
+Usage: bench/fanout.py PORT SERVER_PID [MEMBERS] [LINES] [PRIVMSG|TOPIC] [PASSWORD]
+A channel holds at most irc::MAX_CHANNELS (20) members, the limit +l
+defaults to and is capped at.
+"""
+
+import os
+import resource
+import selectors
+import socket
+import struct
+import sys
+import time
+
+PORT		= int(sys.argv[1])
+SERVER_PID	= int(sys.argv[2])
+MEMBERS		= int(sys.argv[3]) if len(sys.argv) > 3 else 20
+LINES		= int(sys.argv[4]) if len(sys.argv) > 4 else 100
+COMMAND		= sys.argv[5].upper() if len(sys.argv) > 5 else "PRIVMSG"
+PASSWORD	= sys.argv[6] if len(sys.argv) > 6 else "pass"
+CHANNEL		= "#bench"
+COUNTERS	= os.environ.get("IRCSERV_COUNTERS", "/tmp/ircserv.counters")
+
+def	raise_fd_limit(needed):
+	soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+	if soft < needed:
+		resource.setrlimit(resource.RLIMIT_NOFILE, (min(needed, hard), hard))
+
+def	socket_writes():
+	with open(f"/proc/{SERVER_PID}/maps") as maps:
+		if "counters.so" not in maps.read():
+			return None
+	try:
+		with open(COUNTERS, "rb") as counters:
+			return struct.unpack("Q", counters.read(8))[0]
+	except (OSError, struct.error):
+		return None
+
+def	cpu_seconds():
+	"""Run time of every server thread, from the scheduler's nanosecond counters."""
+	total = 0
+	for task in os.listdir(f"/proc/{SERVER_PID}/task"):
+		try:
+			with open(f"/proc/{SERVER_PID}/task/{task}/schedstat") as schedstat:
+				total += int(schedstat.read().split()[0])
+		except OSError:
+			pass
+	return total / 1e9
+
+def	register(nick):
+	sock = socket.create_connection(("127.0.0.1", PORT))
+	sock.sendall(f"PASS {PASSWORD}\r\nNICK {nick}\r\nUSER {nick} 0 * :{nick}\r\nJOIN {CHANNEL}\r\n".encode())
+	sock.setblocking(False)
+	return sock
+
+def	read_until(socks, marker, count):
+	"""Reads every socket until it has seen marker count times."""
+	selector = selectors.DefaultSelector()
+	pending = {}
+	for sock in socks:
+		selector.register(sock, selectors.EVENT_READ)
+		pending[sock] = [0, b""]
+	deadline = time.time() + 120
+	while pending and time.time() < deadline:
+		for key, _ in selector.select(1):
+			state = pending[key.fileobj]
+			data = state[1] + key.fileobj.recv(1 << 20)
+			state[0] += data.count(marker)
+			state[1] = data[-len(marker) + 1:]
+			if state[0] >= count:
+				selector.unregister(key.fileobj)
+				del pending[key.fileobj]
+	selector.close()
+	if pending:
+		sys.exit(f"{len(pending)} of {len(socks)} members did not receive everything")
+
+raise_fd_limit(MEMBERS + 64)
+members = [register(f"m{i}") for i in range(MEMBERS)]
+read_until(members, b" 366 ", 1)
+time.sleep(0.2)
+
+sender, receivers = members[0], members[1:]
+burst = "".join(f"{COMMAND} {CHANNEL} :fan-out line {i}\r\n" for i in range(LINES)).encode()
+writes = socket_writes()
+cpu = cpu_seconds()
+start = time.perf_counter()
+sender.setblocking(True)
+sender.sendall(burst)
+sender.setblocking(False)
+read_until(receivers, b"fan-out line", LINES)
+elapsed = time.perf_counter() - start
+delivered = len(receivers) * LINES
+
+report = (f"{delivered} {COMMAND} lines to {len(receivers)} members in {elapsed * 1000:.1f} ms, "
+	f"{(cpu_seconds() - cpu) * 1000:.1f} ms of server CPU, "
+	f"{(cpu_seconds() - cpu) * 1e9 / delivered:.0f} ns per line")
+if writes is not None:
+	report += f", {(socket_writes() - writes) / delivered:.3f} socket writes per line"
+print(report)
@@ -0,0 +1,20 @@
+#include <string_view>
+#include "Bench.hpp"
+#include "Command.hpp"
+
+/**
+ * @brief Time to parse typical client lines with msgToCmd, one line per iteration.
+ */
+int	main()
+{
+	constexpr std::string_view	privmsg	= "PRIVMSG #channel :hello there, is anyone around to review a patch today?";
+	constexpr std::string_view	join	= "JOIN #channel,#other key";
+	constexpr std::string_view	mode	= ":nick!user@host MODE #channel +ok-l nick secret";
+	constexpr std::string_view	ping	= "PING :1700000000";
+
+	bench::run( "parse PRIVMSG", 2000000, [&]() { bench::keep( msgToCmd( privmsg ).params.size() ); } );
+	bench::run( "parse JOIN", 2000000, [&]() { bench::keep( msgToCmd( join ).params.size() ); } );
+	bench::run( "parse MODE with prefix", 2000000, [&]() { bench::keep( msgToCmd( mode ).params.size() ); } );
+	bench::run( "parse PING", 2000000, [&]() { bench::keep( msgToCmd( ping ).params.size() ); } );
+	return ( 0 );
+}
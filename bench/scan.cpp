@@ -0,0 +1,57 @@
+#include <cstring>
+#include <string>
+#include "Bench.hpp"
+#include "ByteScan.hpp"
+
+namespace
+{
+	const char*	findByteLoop( const char* begin, const char* end, char byte )
+	{
+		while ( begin < end && *begin != byte )
+			++begin;
+		return ( begin );
+	}
+
+	const char*	findByteMemchr( const char* begin, const char* end, char byte )
+	{
+		const void* found = std::memchr( begin, byte, end - begin );
+		return ( found ? static_cast<const char*>( found ) : end );
+	}
+
+	/**
+	 * @brief Frames every line of the paste with find, as ReceiveBuffer does, and counts them.
+	 */
+	template <typename Find>
+	size_t	frame( const std::string& paste, Find find )
+	{
+		const char*	cursor	= paste.data();
+		const char*	end		= cursor + paste.size();
+		size_t		lines	= 0;
+
+		while ( ( cursor = find( cursor, end, '\n' ) ) != end )
+		{
+			++cursor;
+			++lines;
+		}
+		return ( lines );
+	}
+}
+
+/**
+ * @brief Framing throughput over a 1 MiB paste of 400 byte lines, per byte scanned.
+ */
+int	main()
+{
+	std::string	line( 398, 'x' );
+	std::string	paste;
+
+	line += "\r\n";
+	while ( paste.size() + line.size() <= ( 1 << 20 ) )
+		paste += line;
+
+	std::printf( "kernel: %s\n", irc::byteScanKernel() );
+	bench::run( "frame with irc::findByte", 2000, [&]() { bench::keep( frame( paste, irc::findByte ) ); }, "B", paste.size() );
+	bench::run( "frame byte by byte", 200, [&]() { bench::keep( frame( paste, findByteLoop ) ); }, "B", paste.size() );
+	bench::run( "frame with memchr", 2000, [&]() { bench::keep( frame( paste, findByteMemchr ) ); }, "B", paste.size() );
+	return ( 0 );
+}
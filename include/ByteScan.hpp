@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * @brief Vectorized byte search used by line framing and tokenizing.
+ * The kernel is picked once at startup from what the CPU supports: AVX2 compares 64 bytes
+ * per iteration, SSE2 16 bytes, and every other target uses the scalar loop.
+ */
+namespace irc
+{
+	const char*	findByte		( const char* begin, const char* end, char byte ) noexcept;
+	const char*	byteScanKernel	() noexcept;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Name comparison following the advertised CASEMAPPING (irc::CASE_MAPPING, "ascii"):
+ * only A to Z fold to a to z, every other byte is compared as is.
+ */
+namespace irc
+{
+	constexpr char	foldCase( char c ) noexcept
+	{
+		return ( c >= 'A' && c <= 'Z' ) ? static_cast<char>( c + ( 'a' - 'A' ) ) : c;
+	}
+
+	/**
+	 * @brief FNV-1a over the folded name, so names differing only in case hash the same.
+	 * Transparent, a string_view is looked up without building a key string.
+	 */
+	struct CaseInsensitiveHash
+	{
+		using is_transparent = void;
+
+		size_t	operator()( std::string_view name ) const noexcept
+		{
+			uint64_t	hash = 14695981039346656037ULL;
+
+			for ( char c : name )
+				hash = ( hash ^ static_cast<unsigned char>( foldCase( c ) ) ) * 1099511628211ULL;
+			return ( static_cast<size_t>( hash ) );
+		}
+	};
+
+	struct CaseInsensitiveEqual
+	{
+		using is_transparent = void;
+
+		bool	operator()( std::string_view lhs, std::string_view rhs ) const noexcept
+		{
+			if ( lhs.length() != rhs.length() )
+				return ( false );
+			for ( size_t idx = 0; idx < lhs.length(); ++idx )
+			{
+				if ( foldCase( lhs[idx] ) != foldCase( rhs[idx] ) )
+					return ( false );
+			}
+			return ( true );
+		}
+	};
+}
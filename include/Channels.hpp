@@ -1,67 +1,102 @@
 #pragma once
 
 #include <iostream>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include <optional>
+#include "ClientHandle.hpp"
+
+// Compact channel identifier handed out by the server, indexes its channel table
+using ChannelId = uint32_t;
 
 class Channel
 {
+	public:
+		// Member status bits
+		enum MemberFlag : uint8_t
+		{
+			MEMBER_OPERATOR	= 1 << 0
+		};
+
+		struct Member
+		{
+			ClientHandle	client;
+			uint8_t			flags;
+
+			bool	isOperator() const noexcept	{ return flags & MEMBER_OPERATOR; }
+		};
+
 	private:
-		std::string					_name;
-		std::string					_topic;
-		std::string					_key;
-		std::unordered_set<int> 	_members;
-		std::unordered_set<int> 	_operators;
-		std::unordered_set<int> 	_invited;
+		using MemberIndex	= std::pmr::unordered_map<ClientHandle, uint32_t, ClientHandleHash>;
+		using InviteSet		= std::pmr::unordered_set<ClientHandle, ClientHandleHash>;
+
+		std::pmr::string			_name;
+		ChannelId					_id;
+		std::pmr::string			_topic;
+		std::pmr::string			_key;
+		std::pmr::vector<Member>	_members;
+		MemberIndex					_memberIndex;
+		InviteSet					_invited;
 		bool						_inviteOnly;
 		bool						_topicLocked;
 		int							_userLimit;
 
 	public:
-		Channel(const std::string& name);
+		Channel(std::string_view name, ChannelId id, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 
 		//Getters
-		const std::string&					getName			() const;
-		const std::string&					getTopic		() const;
-		const std::unordered_set<int>&		getMembers		() const;
-		const std::unordered_set<int>&		getOperators	() const;
+		const std::pmr::string&				getName			() const;
+		ChannelId							getId			() const;
+		const std::pmr::string&				getTopic		() const;
+		const std::pmr::vector<Member>&		getMembers		() const;
+		const InviteSet&					getInvited		() const;
 		bool								isInviteOnly	() const;
 		bool								isTopicLocked	() const;
-		const std::string&					getKey			() const;
+		const std::pmr::string&				getKey			() const;
 		int									getUserLimit	() const;
 
 		//Setters
-		void	setTopic		(const std::string& topic);
+		void	setTopic		(std::string_view topic);
 		void	setInviteOnly	(bool inviteonly);
 		void	setTopicLocked	(bool topiclocked);
 		void	setUserLimit	(size_t limit);
-		void	setKey			(const std::string& key);
+		void	setKey			(std::string_view key);
 
 		//Membership management
-		bool	addMember		(int clientFd);
-		bool	addOperator		(int clientFd);
-		void	removeMember	(int clientFd);
-		void	removeOperator	(int clientFd);
-		bool	isOperator		(int clientFd);
+		bool	addMember		(ClientHandle client);
+		bool	addOperator		(ClientHandle client);
+		void	removeMember	(ClientHandle client);
+		void	removeOperator	(ClientHandle client);
+		bool	isOperator		(ClientHandle client) const;
 
 		//Invite management
-		void	invite			(int clientFd);
-		bool	isInvited		(int clientFd);
-		void	removeInvite	(int clientFd);
+		void	invite			(ClientHandle client);
+		bool	isInvited		(ClientHandle client);
+		void	removeInvite	(ClientHandle client);
 
 		//Helpers
-		bool	isMember		(int clientFd) const;
+		bool	isMember		(ClientHandle client) const;
 		bool	isFull			() const;
 		bool	isEmpty			() const;
 
+	private:
+		Member*			findMember	(ClientHandle client);
+		const Member*	findMember	(ClientHandle client) const;
 
 };
 
 // _name: Channel name (e.g., #school42).
+// _id: Compact identifier, clients refer to their channels by it instead of by name.
 // _topic: Channel topic (can be empty).
-// _members: Set of client fds in the channel (fast lookup, no duplicates).
-// _operators: Set of client fds with operator privileges.
-// _invited: Set of invited client fds (for invite-only channels).
+// _members: Contiguous array of member handles and their status flags (operator), walked for fan-out and NAMES.
+// _memberIndex: Position of each member handle in _members (fast lookup, no duplicates).
+// Name, topic, key, member storage, index and invites are allocated from the memory resource, the server's object pool.
+// _invited: Set of invited client handles (for invite-only channels), a reused fd does not inherit them.
 // _inviteOnly: If true, only invited users can join (+i mode).
 // _topicLocked: If true, only operators can change the topic (+t mode).
 // _key: Optional password for the channel (+k mode).
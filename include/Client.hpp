@@ -1,118 +1,181 @@
 #pragma once
-#include <unordered_set>
+#include <array>
+#include <atomic>
+#include <span>
 #include <chrono>
+#include <deque>
+#include <memory_resource>
+#include <sys/uio.h>
 #include "headers.hpp"
+#include "MessageBlock.hpp"
+#include "ReceiveBuffer.hpp"
+#include "Channels.hpp"
+#include "ClientHandle.hpp"
+#include "constants.hpp"
+
+struct Shard;
 
 class Client
 {
 private:
 	int										_clientFd;
-	std::string								_username;
-	std::string								_hostname;
-	std::string								_servername;
-	std::string								_nickname; // servername
-	std::string								_realname;
+	ClientHandle							_handle;
+	Shard*									_shard;
+	std::pmr::string						_username;
+	std::pmr::string						_hostname;
+	std::pmr::string						_servername;
+	std::pmr::string						_nickname; // servername
+	std::pmr::string						_realname;
+	std::pmr::string						_prefix;
 	bool									_authenticated;
-	std::unordered_set<std::string>			_channels;
-	std::string								_receiveBuffer;
-	std::string								_sendBuffer;
-	std::string								_ipAddress;
+	std::array<ChannelId, irc::MAX_CHANNELS>	_channels;
+	size_t									_channelCount;
+	std::pmr::vector<ChannelId>				_invites;
+	std::pmr::string						_quitReason;
+	ReceiveBuffer							_receiveBuffer;
+	std::pmr::deque<MessageBlock>			_sendQueue;
+	size_t									_sendOffset;
+	size_t									_sendQueueSize;
+	bool									_sendQueued;
+	bool									_slowConsumer;
+	bool									_readsPaused;
+	bool									_readsDeferred;
+	bool									_reading;
+	uint64_t								_budgetTick;
+	unsigned								_budgetSpent;
+	size_t									_droppedMessages;
+	std::pmr::string						_ipAddress;
 	sockaddr								_clientAddress;
 	int										_passwordAttempts;
 	bool									_passValidated;
-	bool									_active;
+	std::atomic<bool>						_active;
 	bool									_pollout;
+	bool									_sendInFlight;
 	std::chrono::steady_clock::time_point	_connectionTime;
 	std::chrono::steady_clock::time_point	_lastActivity;
 	std::chrono::steady_clock::time_point	_lastPing;
 	bool									_pingPending;
+	std::chrono::steady_clock::time_point	_congestedSince;
+	uint32_t								_timerId;
+
+	void		updatePrefix			();
 
 public:
 	//Constructor/Destructor
-	Client();
+	explicit Client( std::pmr::memory_resource* resource = std::pmr::get_default_resource() );
 	~Client();
 
 	// Getters
 	
 	int												getFd				() const noexcept;
-	const std::string&								getUsername			() const noexcept;
-	const std::string&								getHostname			() const noexcept;
-	const std::string&								getServername		() const noexcept;
-	const std::string&								getNickname			() const noexcept;
-	const std::string&								getRealname			() const noexcept;
+	ClientHandle									getHandle			() const noexcept;
+	Shard*											getShard			() const noexcept;
+	const std::pmr::string&							getUsername			() const noexcept;
+	const std::pmr::string&							getHostname			() const noexcept;
+	const std::pmr::string&							getServername		() const noexcept;
+	const std::pmr::string&							getNickname			() const noexcept;
+	const std::pmr::string&							getRealname			() const noexcept;
+	const std::pmr::string&							getPrefix			() const noexcept;
 	bool											isAuthenticated		() const;
-	std::unordered_set<std::string>&				getChannels			();
-	const std::string&								getIpAddress		() const noexcept;
+	std::span<const ChannelId>						getChannels			() const noexcept;
+	std::span<const ChannelId>						getInvites			() const noexcept;
+	const std::pmr::string&							getQuitReason		() const noexcept;
+	const std::pmr::string&							getIpAddress		() const noexcept;
 	sockaddr&										getClientAddress	();
-	const std::string&								getReceiveBuffer	() const noexcept;
-	const std::string&								getSendBuffer		() const noexcept;
+	ReceiveBuffer&									getReceiveBuffer	() noexcept;
+	size_t											getSendQueueSize	() const noexcept;
+	bool											getSendQueued		() const noexcept;
+	bool											getSlowConsumer		() const noexcept;
+	bool											getReadsPaused		() const noexcept;
+	bool											getReadsDeferred	() const noexcept;
+	bool											getReading			() const noexcept;
+	size_t											getDroppedMessages	() const noexcept;
 	int												getPasswordAttempts	() const noexcept;
 	bool											getPassValidated	() const noexcept;
 	bool											getActive			() const noexcept;
 	bool											getPollout			() const noexcept;
+	bool											getSendInFlight		() const noexcept;
+	size_t											getSendOffset		() const noexcept;
 	const std::chrono::steady_clock::time_point&	getConnectionTime	() const noexcept;
 	const std::chrono::steady_clock::time_point&	getLastActivity		() const noexcept;
 	const std::chrono::steady_clock::time_point&	getLastPing			() const noexcept;
 	bool											getPingPending		() const noexcept;
+	uint32_t										getTimerId			() const noexcept;
 
 	// Setters
 	void		setClientFd				( int fd );
-	void		setUsername				( const std::string& username );
-	void		setHostname				( const std::string& hostname );
-	void		setServername			( const std::string& servername );
-	void		setNickname				( const std::string& nickname );
-	void		setRealname				( const std::string& realname );
-	void		setIpAddress			( const std::string& address );
+	void		setHandle				( ClientHandle handle );
+	void		setShard				( Shard* shard );
+	void		setUsername				( std::string_view username );
+	void		setHostname				( std::string_view hostname );
+	void		setServername			( std::string_view servername );
+	void		setNickname				( std::string_view nickname );
+	void		setRealname				( std::string_view realname );
+	void		setIpAddress			( std::string_view address );
 	void		setClientAddress		( sockaddr address );
 	void		setAuthenticated		( bool auth );
 	void		setPasswordAttempts		( int attempts );
 	void		setPassValidated		( bool valid );
 	void		setActive				( bool active );
 	void		setPollout				( bool required );
+	void		setSendInFlight			( bool inFlight );
+	void		setSendQueued			( bool queued );
+	void		setSlowConsumer			( bool slow );
+	void		setReadsPaused			( bool paused );
+	void		setReadsDeferred		( bool deferred );
+	void		setReading				( bool reading );
 	void		setConnectionTime		( const std::chrono::steady_clock::time_point& time );
 	void		setLastActivity			( const std::chrono::steady_clock::time_point& time );
 	void		setLastPing				( const std::chrono::steady_clock::time_point& time );
 	void		setPingPending			( bool pending );
+	void		setTimerId				( uint32_t id );
+	void		setQuitReason			( std::string_view reason );
 
 	// Buffer management
-	bool		appendToReceiveBuffer	( const std::string& data );
-	bool		appendToSendBuffer		( const std::string& data );
+	bool		appendToSendBuffer		( const MessageBlock& message, bool droppable = false );
 	void		clearReceiveBuffer		();
 	void		clearSendBuffer			();
-	bool		isReceiveBufferComplete	() const;
-	bool		isSendBufferComplete	() const;
-	std::string	extractLineFromReceive	();
-	std::string extractLineFromSend		();
+	bool		hasPendingOutput		() const noexcept;
+	size_t		fillSendVector			( iovec* vectors, size_t count ) const;
+	size_t		fillSendBlocks			( MessageBlock* blocks, size_t count ) const;
+	void		consumeSendBuffer		( size_t bytes );
+	bool		hasFloodBudget			( uint64_t tick );
+	void		spendFloodBudget		( unsigned cost );
 
 	// Channel management
-	void		joinChannel			( const std::string& channel );
-	void		leaveChannel		( const std::string& channel );
-	bool		isInChannel			( const std::string& channel ) const;
+	void		joinChannel			( ChannelId channel );
+	void		leaveChannel		( ChannelId channel );
+	bool		isInChannel			( ChannelId channel ) const;
+	void		addInvite			( ChannelId channel );
+	void		removeInvite		( ChannelId channel );
 
 	// Password authentication
 	void		incrementPassAttempts	();
 
 	// Timeout checks
-	bool		hasRegistrationExpired	();
-	bool		hasPingExpired			();
-	bool		needsPing				();
+	bool		hasRegistrationExpired	( const std::chrono::steady_clock::time_point& now ) const;
+	bool		hasPingExpired			( const std::chrono::steady_clock::time_point& now ) const;
+	bool		hasCongestionExpired	() const;
+	bool		needsPing				( const std::chrono::steady_clock::time_point& now ) const;
 	void		updateConnectionTime	();
 	void		updateLastActivity		();
 	void		updateLastPing			();
-
-protected:
-	// Protected setters
-	void		setReceiveBuffer	( std::string const &buffer );
-	void		setSendBuffer		( std::string const &buffer );
 };
 
 /*
 _client_fd		Identify and communicate with the client (multi-client, non-blocking I/O)
+_handle		Fd and client table generation, what channels and indexes refer to the client by
+_shard			Event loop thread owning the client socket
 _nickname		Unique user identity (NICK command, protocol requirement)
 _username		User authentication (USER command, protocol requirement)
 _realname		Full USER command support
 _hostname		Advanced protocol/logging, recommended
-_buffer			Handle partial/fragmented messages (TCP stream, subject test example)
+_prefix			Source of relayed commands (nick!user@host), rebuilt whenever one of its parts changes
+_receiveBuffer	Handle partial/fragmented messages (TCP stream, subject test example), read into directly
+_sendQueue		Replies waiting for the end of the loop tick, flushed with a single gathered write
+_slowConsumer	Send queue stayed above the high watermark for too long (see BACKPRESSURE CONFIG)
+_invites		Channels which invited the client, their invites are dropped when it disconnects
+_quitReason		Announced to channel members when the connection drops without a QUIT
 authenticated	Enforce authentication before allowing actions
-channels		Track channel membership (JOIN/PART, message forwarding)
+channels		Ids of the joined channels, inline as CHANLIMIT bounds them (JOIN/PART, message forwarding)
  */
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @brief Reference to a client which survives the client: the slot (its fd) and the
+ * generation of the client table slot when the client was stored. Once the client is gone,
+ * the handle no longer resolves, even after the fd was reused by a new client.
+ */
+struct ClientHandle
+{
+	int			slot		= -1;
+	uint32_t	generation	= 0;
+
+	bool	operator==	( const ClientHandle& ) const noexcept	= default;
+	auto	operator<=>	( const ClientHandle& ) const noexcept	= default;
+};
+
+struct ClientHandleHash
+{
+	size_t	operator()( const ClientHandle& handle ) const noexcept
+	{
+		return std::hash<uint64_t>{}( static_cast<uint64_t>( static_cast<uint32_t>( handle.slot ) ) << 32 | handle.generation );
+	}
+};
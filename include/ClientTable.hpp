@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <vector>
+#include "Client.hpp"
+#include "ClientHandle.hpp"
+
+/**
+ * @brief Clients of the server, indexed by their file descriptor.
+ *
+ * The kernel hands out the lowest free descriptor, so the descriptors in use stay dense and
+ * a lookup is a plain index into fixed size pages. Pages are allocated the first time one of
+ * their descriptors is used and never move, so a stored client keeps its address until it is
+ * erased. Iteration walks the pages in descriptor order and skips the free slots.
+ *
+ * Every slot counts how many clients it held, so a reused descriptor can be told apart
+ * from the client which had it before. A ClientHandle pairs the descriptor with that count,
+ * looking up the handle of a client which is gone finds nothing.
+ *
+ * The slots themselves are the pool of Client objects, a new client is constructed in the slot
+ * of its descriptor. Their buffers are allocated from the memory resource given to the table.
+ */
+class ClientTable
+{
+	private:
+		static constexpr size_t	PAGE_SIZE = 256;
+
+		struct Slot
+		{
+			std::optional<Client>	client;
+			uint32_t				generation = 0;
+		};
+
+		std::vector<std::unique_ptr<Slot[]>>	_pages;
+		size_t									_size;
+		std::pmr::memory_resource*				_resource;
+
+		Slot*		slot		( int fd ) const noexcept;
+
+	public:
+		template <typename Table, typename Value>
+		class Iterator
+		{
+			private:
+				Table*	_table;
+				size_t	_index;
+
+				void	skipFree() noexcept
+				{
+					while ( _index < _table->capacity() && !_table->find( static_cast<int>( _index ) ) )
+						++_index;
+				}
+
+			public:
+				Iterator( Table* table, size_t index ) noexcept : _table( table ), _index( index ) { skipFree(); }
+
+				Value&		operator*	() const noexcept						{ return *_table->find( static_cast<int>( _index ) ); }
+				Value*		operator->	() const noexcept						{ return _table->find( static_cast<int>( _index ) ); }
+				Iterator&	operator++	() noexcept								{ ++_index; skipFree(); return *this; }
+				bool		operator==	( const Iterator& other ) const noexcept	{ return _index == other._index; }
+		};
+
+		using iterator			= Iterator<ClientTable, Client>;
+		using const_iterator	= Iterator<const ClientTable, const Client>;
+
+		explicit ClientTable( std::pmr::memory_resource* resource = std::pmr::get_default_resource() );
+
+		Client&			emplace		( int fd );
+		void			erase		( int fd );
+		void			clear		();
+		Client*			find		( int fd ) noexcept;
+		const Client*	find		( int fd ) const noexcept;
+		Client*			find		( ClientHandle handle ) noexcept;
+		const Client*	find		( ClientHandle handle ) const noexcept;
+		ClientHandle	handle		( int fd ) const noexcept;
+		uint32_t		generation	( int fd ) const noexcept;
+		size_t			size		() const noexcept;
+		size_t			capacity	() const noexcept;
+		bool			empty		() const noexcept;
+
+		iterator		begin		() noexcept			{ return iterator( this, 0 ); }
+		iterator		end			() noexcept			{ return iterator( this, capacity() ); }
+		const_iterator	begin		() const noexcept	{ return const_iterator( this, 0 ); }
+		const_iterator	end			() const noexcept	{ return const_iterator( this, capacity() ); }
+};
@@ -1,15 +1,73 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
-#include <vector>
-#include <sstream>
+#include <string_view>
 #include <ctype.h>
 
+/**
+ * @brief Parameters of a parsed message, kept inline. The protocol allows at most 15.
+ * Every parameter is a view into the parsed line.
+ */
+class CommandParams
+{
+	public:
+		static constexpr size_t	MAX_PARAMS = 15;
+
+	private:
+		std::array<std::string_view, MAX_PARAMS>	_params;
+		size_t										_size = 0;
+
+	public:
+		using const_iterator = std::array<std::string_view, MAX_PARAMS>::const_iterator;
+
+		size_t					size		() const noexcept			{ return _size; }
+		bool					empty		() const noexcept			{ return _size == 0; }
+		const std::string_view&	operator[]	( size_t index ) const noexcept	{ return _params[index]; }
+		const_iterator			begin		() const noexcept			{ return _params.begin(); }
+		const_iterator			end			() const noexcept			{ return _params.begin() + _size; }
+		void					push_back	( std::string_view param ) noexcept	{ _params[_size++] = param; }
+};
+
+/**
+ * @brief Commands known to the server, recognized while parsing. Indexes the dispatch table.
+ */
+enum class CommandType : uint8_t
+{
+	UNKNOWN,
+	PASS,
+	NICK,
+	USER,
+	PRIVMSG,
+	NOTICE,
+	JOIN,
+	PART,
+	KICK,
+	INVITE,
+	TOPIC,
+	MODE,
+	QUIT,
+	PING,
+	PONG,
+	SUMMON,
+	USERS,
+	WHOIS,
+	WHO,
+	COUNT
+};
+
+/**
+ * @brief A parsed message. It only holds views into the line it was parsed from,
+ * so it must not outlive the receive buffer holding that line.
+ * The command is kept as sent, type holds what it was recognized as, regardless of case.
+ */
 struct Command
 {
-	std::string					prefix;
-	std::string					command;
-	std::vector<std::string>	params;
+	std::string_view	prefix;
+	std::string_view	command;
+	CommandType			type = CommandType::UNKNOWN;
+	CommandParams		params;
 };
 
-Command msgToCmd(std::string message);
+Command msgToCmd(std::string_view message);
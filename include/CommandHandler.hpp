@@ -1,14 +1,18 @@
 #pragma once
 #include <functional>
+#include <cstdint>
+#include <string_view>
 #include <unordered_map>
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include "Command.hpp"
+#include "MessageBlock.hpp"
+#include "ScratchArena.hpp"
 
 class	Server;
 class	Client;
 class	Channel;
-struct	Command;
 struct	Mode;
 
 class	CommandHandler
@@ -16,10 +20,27 @@ class	CommandHandler
 
 	private:
 			Server&	_server;
-			// std::function allows us to store any callable (lambda, function pointer, etc.). "using" is a type alias for handler functions
-			using HandleFunction = std::function<void(Client&, const Command&)>;
-			// Mapping command name with the handler function
-			std::unordered_map<std::string, HandleFunction>	_handlers;
+
+			// Member function handling one command
+			using HandleFunction = void (CommandHandler::*)(Client&, const Command&);
+
+			/**
+			 * @brief Dispatch entry of one command. The checks every handler would otherwise repeat
+			 * are done from here before the handler is called.
+			 */
+			struct CommandSpec
+			{
+				const char*		name;
+				HandleFunction	handler;
+				bool			registered;	// ERR_NOTREGISTERED until the client has registered
+				uint8_t			minParams;	// ERR_NEEDMOREPARAMS below this many parameters
+				bool			logged;		// Logged when irc::ENABLE_COMMAND_LOGGING is set
+				bool			exclusive;	// Holds the state lock exclusively, it changes shared state
+				uint8_t			floodCost;	// Relative weight of the command for flood control
+			};
+
+			// Indexed by CommandType, UNKNOWN has no handler
+			static const CommandSpec	_commands[static_cast<size_t>(CommandType::COUNT)];
 
 			// Registration commands
 			void	handlePass		(Client&, const Command&);
@@ -50,10 +71,10 @@ class	CommandHandler
 
 
 			// Helper functions for handling modes
-			void	handleChannelMode(Client& client, const Command& cmd, const std::string& channelName);
-			void	sendChannelModeReply(Client& client, Channel* channel, const std::string& channelName);
+			void	handleChannelMode(Client& client, const Command& cmd, std::string_view channelName);
+			void	sendChannelModeReply(Client& client, Channel* channel, std::string_view channelName);
 			bool	parseChannelModes(Client& client, const Command& cmd, std::vector<Mode>& modes);
-			bool	constructModeNodes( Client& client, const Command& cmd, const std::string& tokens, size_t& paramIndex, std::vector<Mode>& modes );
+			bool	constructModeNodes( Client& client, const Command& cmd, std::string_view tokens, size_t& paramIndex, std::vector<Mode>& modes );
 			void	applyChannelModes(Client& client, Channel& channel, std::vector<Mode>& modes);
 
 			void	handleModeInviteOnly(Channel& channel, bool adding);
@@ -63,31 +84,35 @@ class	CommandHandler
 			void	handleModeOperator(Client& client, Channel& channel, bool adding, const Mode& mode);
 
 			// Channel broadcasting functions
+			void	broadcastLine		( Channel& channel, const MessageBlock& line, const Client* except, bool droppable );
 			void	broadcastJoin		( Client& client, Channel& channel );
-			void	broadcastPrivmsg	( Client& client, Channel& channel, const std::string& message );
-			void	broadcastNotice		( Client& client, Channel& channel, const std::string& message );
-			void	broadcastPart		( Client& client, Channel& channel, const std::string& message );
-			void	broadcastKick		( Client& client, Client& target, Channel& channel, const std::string & message );
-			void	broadcastQuit		( Client& client, const std::string& message );
-			void	broadcastMode		( Client& client, Channel& channel, const std::string& modeStr);
-			void	broadcastTopic		( Client& client, Channel& channel, const std::string& newTopic );
+			void	broadcastPrivmsg	( Client& client, Channel& channel, std::string_view message );
+			void	broadcastNotice		( Client& client, Channel& channel, std::string_view message );
+			void	broadcastPart		( Client& client, Channel& channel, std::string_view message );
+			void	broadcastKick		( Client& client, Client& target, Channel& channel, std::string_view message );
+			void	broadcastMode		( Client& client, Channel& channel, std::string_view modeStr );
+			void	broadcastTopic		( Client& client, Channel& channel, std::string_view newTopic );
 
 			// Authorization function
 			bool	confirmAuth			( Client& client );
 
 			// Static helper functions
-			static bool			isValidNick		( const std::string& nick );
-			static bool			isChannelName	( const std::string& name );
-			static std::string	toLowerCase		( const std::string& s );
+			static bool					isValidNick		( std::string_view nick );
+			static bool					isChannelName	( std::string_view name );
+			static irc::ScratchString	toLowerCase		( std::string_view s );
+			static std::string_view		logName			( const Client& client );
 
 			// Mode related static hellper functions
 			static bool			isMode			( char mode );
 			static bool			isSign			( char sign );
 			static bool			requiresParam	( char mode, bool adding );
-			static std::string	inlineParam		( const std::string& tokens, size_t& index, std::function<bool(char)> condition );
+			static std::string	inlineParam		( std::string_view tokens, size_t& index, std::function<bool(char)> condition );
 
 	public:
 			CommandHandler(Server& server);
 			void	handleCommand(Client& client, const Command& cmd);
+			static bool		isExclusive(CommandType type);
+			static unsigned	floodCost(CommandType type);
+			void	broadcastQuit(Client& client, std::string_view message);
 
 };
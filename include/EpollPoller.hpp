@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Poller.hpp"
+#include <sys/epoll.h>
+
+/**
+ * @brief Linux epoll(7) backend. Client sockets are registered edge-triggered,
+ * so the owner must drain a ready socket until EAGAIN.
+ */
+class EpollPoller : public Poller
+{
+	private:
+		struct Entry
+		{
+			void*		data		= nullptr;
+			uint32_t	flags		= 0;
+			bool		registered	= false;
+		};
+
+		int							_epollFd;
+		std::vector<Entry>			_entries;
+		std::vector<epoll_event>	_events;
+
+		EpollPoller( const EpollPoller& )				= delete;
+		EpollPoller& operator=( const EpollPoller& )	= delete;
+
+		static uint32_t	toEpoll		( short events ) noexcept;
+		static short	fromEpoll	( uint32_t events ) noexcept;
+
+	public:
+		EpollPoller();
+		~EpollPoller() override;
+
+		bool		add			( int fd, short events, void* data, bool edgeTriggered = true ) override;
+		bool		modify		( int fd, short events ) override;
+		void		remove		( int fd ) override;
+		int			wait		( std::vector<PollEvent>& ready, int timeoutMillis ) override;
+		const char*	name		() const noexcept override;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Poller.hpp"
+#include "constants.hpp"
+#include <array>
+#include <chrono>
+#include <unordered_map>
+#include <linux/io_uring.h>
+
+/**
+ * @brief Linux io_uring(7) engine. Instead of reporting readiness it performs the I/O itself:
+ * listeners get a multishot accept, clients get a multishot recv into provided buffers,
+ * and queued output is written with a sendmsg request per client gathering up to
+ * irc::MAX_SEND_VECTORS blocks, one write per client in flight. POLLOUT is a oneshot poll
+ * request, re-armed on the next wait for as long as it stays registered; with sends handled
+ * by the ring the server only asks for it if a write could not be queued.
+ * Descriptors which are not sockets get a multishot poll request instead and are reported as
+ * plain readiness. Every request queued during a loop tick, sends included, is submitted by
+ * the single io_uring_enter call which also waits for the next completions.
+ */
+class IoUringPoller : public Poller
+{
+	private:
+		enum Request : uint8_t
+		{
+			REQ_ACCEPT = 1,
+			REQ_RECV,
+			REQ_POLLIN,
+			REQ_POLLOUT,
+			REQ_SEND,
+			REQ_IGNORED
+		};
+
+		struct Entry
+		{
+			void*		data			= nullptr;
+			uint32_t	generation		= 0;
+			bool		registered		= false;
+			bool		listener		= false;
+			bool		socket			= false;
+			bool		recvArmed		= false;
+			bool		polloutWanted	= false;
+			bool		polloutArmed	= false;
+			bool		sendArmed		= false;
+		};
+
+		// A write in flight, its blocks stay referenced until the kernel is done with them
+		struct Send
+		{
+			msghdr											header	= {};
+			std::array<iovec, irc::MAX_SEND_VECTORS>		vectors;
+			std::array<MessageBlock, irc::MAX_SEND_VECTORS>	blocks;
+		};
+		using SendTable = std::unordered_map<uint64_t, Send>;
+
+		// A listener whose accept failed, queued again once due unless it was removed meanwhile
+		struct AcceptRetry
+		{
+			int										fd;
+			uint32_t								generation;
+			std::chrono::steady_clock::time_point	due;
+		};
+
+		int						_ringFd;
+		void*					_sqRing;
+		void*					_cqRing;
+		io_uring_sqe*			_sqes;
+		size_t					_sqRingSize;
+		size_t					_cqRingSize;
+		size_t					_sqesSize;
+
+		// Submission queue
+		unsigned*				_sqHead;
+		unsigned*				_sqTail;
+		unsigned*				_sqMask;
+		unsigned*				_sqArray;
+		unsigned				_sqEntries;
+		unsigned				_pending;
+
+		// Completion queue
+		unsigned*				_cqHead;
+		unsigned*				_cqTail;
+		unsigned*				_cqMask;
+		io_uring_cqe*			_cqes;
+
+		// Provided receive buffers
+		std::vector<char>		_buffers;
+		std::vector<uint16_t>	_recycle;
+
+		// Sockets whose oneshot POLLOUT fired while the owner still wants it
+		std::vector<int>		_rearm;
+
+		// Listeners waiting out a failed accept
+		std::vector<AcceptRetry>	_acceptRetries;
+
+		std::vector<Entry>		_entries;
+
+		// Writes in flight by user_data, finished nodes are kept for the next write
+		SendTable							_sends;
+		std::vector<SendTable::node_type>	_spareSends;
+
+		IoUringPoller( const IoUringPoller& )				= delete;
+		IoUringPoller& operator=( const IoUringPoller& )	= delete;
+
+		io_uring_sqe*	nextSqe			();
+		int				submit			( unsigned waitFor, int timeoutMillis );
+		void			queueAccept		( int fd );
+		void			queueRecv		( int fd );
+		void			queuePollin		( int fd );
+		void			queuePollout	( int fd );
+		void			queueCancel		( uint64_t userData );
+		void			queueBuffers	( uint16_t bufferId, unsigned count );
+		void			finishSend		( uint64_t key );
+		bool			probeMultishot	();
+		uint64_t		userData		( Request request, int fd ) const noexcept;
+		void			unmapRings		() noexcept;
+
+	public:
+		IoUringPoller();
+		~IoUringPoller() override;
+
+		bool		add			( int fd, short events, void* data, bool edgeTriggered = true ) override;
+		bool		modify		( int fd, short events ) override;
+		void		remove		( int fd ) override;
+		int			wait		( std::vector<PollEvent>& ready, int timeoutMillis ) override;
+		const char*	name		() const noexcept override;
+		bool		send		( int fd, std::span<const MessageBlock> blocks, size_t offset ) override;
+};
@@ -5,11 +5,14 @@
 #include <chrono>
 #include <iomanip>
 #include <sstream>
+#include <mutex>
+#include <string_view>
 
 class Logger
 {
 	private:
 		static size_t	_functionLength;
+		std::mutex		_outputMutex;
 
 		Logger();
 		Logger( const Logger& )				= delete;
@@ -18,6 +21,6 @@ class Logger
 	public:
 		static Logger&		instance();
 		static std::string	timestamp();
-		void				log( const std::string& func, const std::string& status, const std::string& msg);
+		void				log( std::string_view func, std::string_view status, std::string_view msg );
 
 };
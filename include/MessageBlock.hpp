@@ -0,0 +1,10 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief Immutable rendered wire line. A broadcast renders it once and every recipient's
+ * send queue holds a reference to the same block, the last reference frees it.
+ */
+using MessageBlock = std::shared_ptr<const std::string>;
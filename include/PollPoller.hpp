@@ -0,0 +1,26 @@
+#pragma once
+
+#include "Poller.hpp"
+
+/**
+ * @brief Portable fallback backend built on poll(2). Always level-triggered.
+ * Keeps an fd to slot index next to the pollfd array, so updates and swap-removals are constant time.
+ */
+class PollPoller : public Poller
+{
+	private:
+		static constexpr size_t	NO_SLOT = static_cast<size_t>(-1);
+
+		std::vector<pollfd>	_fds;
+		std::vector<void*>	_data;
+		std::vector<size_t>	_slots;
+
+	public:
+		PollPoller() = default;
+
+		bool		add			( int fd, short events, void* data, bool edgeTriggered = true ) override;
+		bool		modify		( int fd, short events ) override;
+		void		remove		( int fd ) override;
+		int			wait		( std::vector<PollEvent>& ready, int timeoutMillis ) override;
+		const char*	name		() const noexcept override;
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "headers.hpp"
+#include "MessageBlock.hpp"
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A single notification returned by Poller::wait.
+ * Events are expressed with the poll(2) flags (POLLIN, POLLOUT, POLLERR, POLLHUP, POLLNVAL)
+ * regardless of which backend produced them.
+ *
+ * Completion based backends perform the accept or recv themselves and set completed:
+ * result then holds the accepted fd or the received byte count (0 on EOF, -errno on failure),
+ * and buffer points to the received bytes until the next call to wait.
+ * A completed POLLOUT event is the end of a write started with Poller::send,
+ * result holds the written byte count or -errno.
+ */
+struct PollEvent
+{
+	int			fd;
+	short		events;
+	void*		data;
+	bool		completed	= false;
+	int			result		= 0;
+	const char*	buffer		= nullptr;
+};
+
+/**
+ * @brief Readiness backend interface used by the server event loop.
+ * Every backend keeps its own per-fd state, so a ready event carries the data pointer
+ * registered with the fd and the caller never has to scan for it.
+ */
+class Poller
+{
+	public:
+		virtual ~Poller() = default;
+
+		virtual bool		add			( int fd, short events, void* data, bool edgeTriggered = true ) = 0;
+		virtual bool		modify		( int fd, short events ) = 0;
+		virtual void		remove		( int fd ) = 0;
+		virtual int			wait		( std::vector<PollEvent>& ready, int timeoutMillis ) = 0;
+		virtual const char*	name		() const noexcept = 0;
+		virtual bool		send		( int fd, std::span<const MessageBlock> blocks, size_t offset );
+
+		static std::unique_ptr<Poller>	create	();
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Per-client input buffer the socket is read into directly.
+ *
+ * Received bytes stay where the kernel put them. Lines are framed in place by a single
+ * forward scan, which resumes where the previous one stopped, and handed out as views
+ * into the buffer. A view stays valid until the next call to reserve or clear.
+ *
+ * Consumed lines only advance the read position. The unframed tail is moved back to the
+ * front once the free space runs low, so a line is always contiguous.
+ *
+ * The storage comes from the given memory resource, so a closed connection hands it back
+ * to the server's object pool for the next one.
+ */
+class ReceiveBuffer
+{
+	private:
+		std::pmr::vector<char>	_data;
+		size_t					_begin;
+		size_t					_end;
+		size_t					_scanned;
+
+	public:
+		explicit ReceiveBuffer( std::pmr::memory_resource* resource = std::pmr::get_default_resource() );
+
+		void	reserve		();
+		char*	writeData	() noexcept;
+		size_t	writeSpace	() const noexcept;
+		void	commit		( size_t bytes ) noexcept;
+		bool	nextLine	( std::string_view& line ) noexcept;
+		size_t	size		() const noexcept;
+		void	clear		() noexcept;
+};
@@ -1,18 +1,31 @@
 #pragma once
 
 #include "headers.hpp"
-#include <unordered_map>
+#include "MessageBlock.hpp"
+#include "ResponseTemplate.hpp"
+#include <initializer_list>
 
 class Server;
 class Channel;
 class Client;
+enum class CommandType : uint8_t;
 
 class Response
 {
 	public:
-		using string_map = std::unordered_map<std::string, std::string>;
+		using Field = ResponseField;
+
+		/// A placeholder value passed by the caller, it only has to live until the call returns
+		struct Arg
+		{
+			Field				field;
+			std::string_view	value;
+		};
+		using Args = std::initializer_list<Arg>;
 
 	private:
+		using FieldValues = std::array<std::string_view, static_cast<size_t>(Field::COUNT)>;
+
 		static std::string	_date;
 		static std::string	_server;
 		static std::string	_version;
@@ -20,14 +33,15 @@ class Response
 
 		Response() = delete;
 
-		static std::string	formatCode					( int code );
-		static std::string	getResponseTemplate			( int code );
-		static std::string	getCommandTemplate			( const std::string& command );
-		static std::string	findAndReplacePlaceholders	( const std::string& template_string, const string_map& placeholders );
+		static std::array<char, 3>		formatCode			( int code );
+		static const ResponseTemplate*	getResponseTemplate	( int code );
+		static const ResponseTemplate*	getCommandTemplate	( CommandType command, bool withReason );
+		static MessageBlock				render				( const ResponseTemplate& format, const FieldValues& values, Args args );
 
 	public:
-		/// Function for sending messages directly to the client
-		static void	sendMessage							( Client& client, const std::string& message );
+		/// Functions for queueing messages to the client
+		static void			sendMessage					( Client& client, const MessageBlock& message, bool droppable = false );
+		static MessageBlock	renderCommand				( CommandType command, Client& source, Args args );
 
 		/// Static member variable setters
 		static void	setServerDate						( const std::string& date );
@@ -36,14 +50,15 @@ class Response
 		static void	setIsupport							( const std::string& message );
 
 		/// Functions for sending messages
-		static void	sendResponseCode					( int code, Client& client, const string_map& placeholders );
-		static void	sendResponseCommand					( const std::string& command, Client& source, Client& target, const string_map& placeholders );
-		static void	sendPartialResponse					( Client& client );
-
-		static void	sendServerNotice					( Client& client, const std::string& notice );
-		static void	sendServerError						( Client& target, const std::string& ipAddress, const std::string& reason );
-		static void	sendPing							( Client& target, const std::string& token );
-		static void	sendPong							( Client& target, const std::string& token );
+		static void	sendResponseCode					( int code, Client& client, Args args = {} );
+		static void	sendResponseCommand					( CommandType command, Client& source, Client& target, Args args );
+		static bool	flushMessages						( Client& client );
+		static bool	submitMessages						( Client& client );
+
+		static void	sendServerNotice					( Client& client, std::string_view notice );
+		static void	sendServerError						( Client& target, std::string_view ipAddress, std::string_view reason );
+		static void	sendPing							( Client& target, std::string_view token );
+		static void	sendPong							( Client& target, std::string_view token );
 
 		/// Welcome the user
 		static void	sendWelcome							( Client& client );
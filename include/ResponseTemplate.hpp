@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Placeholders which may appear in a response template, written as <name> in the template text.
+ */
+enum class ResponseField : uint8_t
+{
+	SERVER,
+	CODE,
+	NICK,
+	USER,
+	HOST,
+	DATE,
+	VERSION,
+	TARGET,
+	COMMAND,
+	CHANNEL,
+	USERS,
+	NAMES,
+	REAL_NAME,
+	NEW_NICK,
+	TOPIC,
+	SYMBOL,
+	PARAM,
+	VALUE,
+	TEXT,
+	SERVER_INFO,
+	USER_MODES,
+	CHANNEL_MODES,
+	MODE,
+	MODE_PARAMS,
+	MESSAGE,
+	REASON,
+	FLAGS,
+	SOURCE,
+	COUNT
+};
+
+/**
+ * @brief Response template split into literal and placeholder segments at compile time.
+ * An unknown placeholder or a template with too many segments does not compile.
+ */
+class ResponseTemplate
+{
+	public:
+		struct Segment
+		{
+			std::string_view	literal;
+			ResponseField		field	= ResponseField::COUNT;
+			bool				isField	= false;
+		};
+
+	private:
+		static constexpr size_t	MAX_SEGMENTS = 16;
+
+		std::array<Segment, MAX_SEGMENTS>	_segments;
+		size_t								_count;
+
+		static consteval ResponseField	fieldByName( std::string_view name )
+		{
+			constexpr std::array<std::string_view, static_cast<size_t>(ResponseField::COUNT)> names =
+			{
+				"server", "code", "nick", "user", "host", "date", "version", "target", "command",
+				"channel", "users", "names", "real name", "new nick", "topic", "symbol", "param",
+				"value", "text", "server info", "user modes", "channel modes", "mode", "mode params",
+				"message", "reason", "flags", "source"
+			};
+
+			for ( size_t idx = 0; idx < names.size(); ++idx )
+			{
+				if ( names[idx] == name )
+					return static_cast<ResponseField>( idx );
+			}
+			throw "unknown response template placeholder";
+		}
+
+		consteval void	push( const Segment& segment )
+		{
+			if ( _count == MAX_SEGMENTS )
+				throw "response template has too many segments";
+			_segments[_count++] = segment;
+		}
+
+	public:
+		consteval ResponseTemplate( std::string_view text ) : _segments(), _count( 0 )
+		{
+			size_t	position = 0;
+
+			while ( position < text.length() )
+			{
+				size_t open		= text.find( '<', position );
+				size_t close	= ( open == std::string_view::npos ) ? open : text.find( '>', open );
+
+				if ( close == std::string_view::npos )
+				{
+					push( { text.substr( position ), ResponseField::COUNT, false } );
+					break ;
+				}
+				if ( open > position )
+					push( { text.substr( position, open - position ), ResponseField::COUNT, false } );
+				push( { {}, fieldByName( text.substr( open + 1, close - open - 1 ) ), true } );
+				position = close + 1;
+			}
+		}
+
+		const Segment*	begin	() const noexcept	{ return _segments.data(); }
+		const Segment*	end		() const noexcept	{ return _segments.data() + _count; }
+};
+
+/**
+ * @brief String literal usable as a template argument, so every template is compiled once into a constant.
+ */
+template <size_t N>
+struct ResponseTemplateText
+{
+	char	text[N];
+
+	consteval ResponseTemplateText( const char ( &literal )[N] )	{ std::copy_n( literal, N, text ); }
+	consteval std::string_view	view() const					{ return std::string_view( text, N - 1 ); }
+};
+
+/**
+ * @brief The compiled form of a template literal, e.g. &compiledTemplate<":<server> <code> <nick>\r\n">
+ */
+template <ResponseTemplateText text>
+inline constexpr ResponseTemplate compiledTemplate( text.view() );
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include "constants.hpp"
+
+/**
+ * @brief Monotonic arena for the strings built while handling a command or an event loop tick:
+ * lowercased channel names, mode and NAMES lists, log lines.
+ *
+ * Allocations are a pointer bump into a fixed buffer owned by the shard, falling back to the heap
+ * only when a single command outgrows it. Nothing is freed one by one, release drops everything
+ * at once. The shard releases the arena after every command it executes and at the start of
+ * every tick, so a flood of commands keeps reusing the fixed buffer.
+ * Every event loop thread makes its shard's arena current, so code handling a command reaches it
+ * through irc::scratch() instead of passing it down every call.
+ *
+ * Scratch data must not outlive the command or tick. Anything stored on a client or channel,
+ * or queued for sending, is copied out of the arena.
+ */
+class ScratchArena
+{
+	private:
+		static thread_local ScratchArena*	_current;
+
+		std::array<std::byte, irc::SCRATCH_ARENA_SIZE>	_buffer;
+		std::pmr::monotonic_buffer_resource				_resource;
+
+	public:
+		ScratchArena();
+		~ScratchArena();
+
+		ScratchArena( const ScratchArena& )				= delete;
+		ScratchArena& operator=( const ScratchArena& )	= delete;
+
+		void								makeCurrent	() noexcept;
+		void								release		() noexcept;
+		static std::pmr::memory_resource*	current		() noexcept;
+};
+
+namespace irc
+{
+	using ScratchString = std::pmr::string;
+
+	/**
+	 * @brief The calling thread's scratch arena, or the default resource on a thread without one.
+	 */
+	inline std::pmr::memory_resource*	scratch() noexcept
+	{
+		return ( ScratchArena::current() );
+	}
+
+	/**
+	 * @brief Joins the parts into a single scratch string, sized up front.
+	 */
+	template <typename... Parts>
+	ScratchString	concat( const Parts&... parts )
+	{
+		ScratchString	result( scratch() );
+
+		result.reserve( ( std::string_view( parts ).length() + ... ) );
+		( result.append( std::string_view( parts ) ), ... );
+		return ( result );
+	}
+}
@@ -2,32 +2,47 @@
 
 #include "headers.hpp"
 #include <vector>
+#include <string_view>
 #include <unordered_map>
 #include <chrono>
+#include <memory>
+#include <memory_resource>
+#include <shared_mutex>
+#include <atomic>
 #include "CommandHandler.hpp"
+#include "Channels.hpp"
+#include "Shard.hpp"
+#include "ClientTable.hpp"
+#include "CaseMapping.hpp"
 
-class	Channel;
 struct	Command;
 class	Client;
 
 class Server
 {
+	public:
+		using ChannelRegistry = std::pmr::unordered_map<std::pmr::string, Channel, irc::CaseInsensitiveHash, irc::CaseInsensitiveEqual>;
+
 	private:
+		using NicknameIndex = std::pmr::unordered_map<std::pmr::string, ClientHandle, irc::CaseInsensitiveHash, irc::CaseInsensitiveEqual>;
+
 		int										_port;
 		std::string								_password;
-		int										_serverSocket;
-		std::unordered_map<unsigned, Client>	_clients;
-		std::vector<Channel>					_channels;
-		std::vector<pollfd>						_fds;
+		std::pmr::synchronized_pool_resource	_objectPool;
+		ClientTable								_clients;
+		NicknameIndex							_nicknames;
+		ChannelRegistry							_channels;
+		std::vector<Channel*>					_channelIds;
+		std::vector<ChannelId>					_freeChannelIds;
+		std::vector<std::unique_ptr<Shard>>		_shards;
+		std::shared_mutex						_stateMutex;
 		sockaddr								_serverAddress;
 		std::string								_serverStartTime;
 		std::string								_serverHostname;
 		const std::string						_serverVersion;
-		static bool								_terminate;
+		static std::atomic<bool>				_terminate;
+		static thread_local Shard*				_localShard;
 		CommandHandler							_commandHandler;
-		static bool								_disconnectEvent;
-		static bool								_polloutEvent;
-		std::chrono::steady_clock::time_point	_lastTimeoutCheck;
 
 		Server()								= delete;
 		Server( const Server& )					= delete;
@@ -37,8 +52,19 @@ class Server
 		static void 		signalHandler			( int signum );
 		std::string			fetchHostname			();
 		static void			fetchClientIp			( Client& client );
-		void				setClientsToPollout		();
-		void				checkTimeouts			();
+		void				createListener			( Shard& shard );
+		void				shardLoop				( Shard& shard );
+		void				flushClients			( Shard& shard );
+		void				deliverForwarded		( Shard& shard );
+		void				deferReads				( Shard& shard, Client& client );
+		void				resumeDeferredReads		( Shard& shard );
+		void				updateClientEvents		( Shard& shard, Client& client );
+		void				completeClientSend		( Shard& shard, Client& client, int result );
+		void				processTimers			( Shard& shard );
+		void				scheduleClientTimer		( Shard& shard, Client& client, const std::chrono::steady_clock::time_point& deadline );
+		void				runClientTimer			( Shard& shard, Client& client, const std::chrono::steady_clock::time_point& now );
+		void				timeoutClient			( Client& client, const std::string& reason );
+		void				reportQueueMetrics		( Shard& shard );
 		static void			buildSSupportMessage	();
 
 	public:
@@ -48,25 +74,32 @@ class Server
 		const std::string&							getServerStartTime	() const;
 		const std::string&							getServerHostname	() const;
 		const std::string&							getServerVersion	() const;
-		const std::unordered_map<unsigned, Client>& getClients			() const;
+		ClientTable&								getClients			();
 		const std::string&							getPassword			() const;
-		const std::vector<Channel>					getChannels			() const;
+		const ChannelRegistry&						getChannels			() const;
 
-		static void	setDisconnectEvent	( bool event );
-		static void	setPolloutEvent		( bool event );
+		static void	setDisconnectEvent	( Client& client );
+		static void	setSendEvent		( Client& client );
+		static bool	forwardMessage		( Client& client, const MessageBlock& message, bool droppable );
 
 		void		serverSetup				();
 		void		serverLoop				();
-		bool		acceptClientConnection	( std::vector<pollfd>& new_clients );
-		bool		receiveClientMessage	( int file_descriptor );
-		void		disconnectClients		();
+		size_t		acceptClientConnection	( Shard& shard );
+		bool		adoptClientConnection	( Shard& shard, int file_descriptor );
+		bool		registerClient			( Shard& shard, int file_descriptor, const sockaddr& address );
+		bool		receiveClientMessage	( Shard& shard, Client& client );
+		bool		receiveCompletedMessage	( Shard& shard, Client& client, const char* data, ssize_t bytes );
+		bool		executeReceivedMessages	( Shard& shard, Client& client, bool budgeted = true );
+		void		disconnectClients		( Shard& shard );
 		void		executeCommand			( Client& client, Command& cmd);
 		void		broadcastShutdown		( const std::string& reason );
 
-		void		addChannel				( const std::string channelName);
-		void		removeChannel			( const std::string& channelName);
-		Channel*	findChannel				( const std::string& channelName );
-		Client*		findUser				( const std::string& nickName );
+		void		addChannel				( std::string_view channelName );
+		void		removeChannel			( std::string_view channelName );
+		Channel*	findChannel				( std::string_view channelName );
+		Channel*	findChannel				( ChannelId channelId );
+		Client*		findUser				( std::string_view nickName );
+		void		renameUser				( Client& client, std::string_view nickName );
+		void		scheduleKeepalive		( Client& client );
 
 };
-
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "headers.hpp"
+#include "ClientHandle.hpp"
+#include "MessageBlock.hpp"
+#include "Poller.hpp"
+#include "ScratchArena.hpp"
+#include "TimerWheel.hpp"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <thread>
+
+class	Client;
+
+/**
+ * @brief One event loop thread of the server.
+ *
+ * Ownership model:
+ * - A shard owns its listener, its event backend, its timer wheel and the clients it accepted:
+ *   their sockets, receive buffers, send queues and timers. Only the owning shard reads from,
+ *   writes to, polls, times out, disconnects or erases those clients, without the state lock.
+ * - Nicknames, channels and the identity of every client (nickname, user, joined channels)
+ *   live in the Server and are shared by all shards, behind the server state lock.
+ *   Commands which only read them share the lock, the rest hold it exclusively.
+ * - A line for a client of another shard is never queued remotely. It is forwarded into the
+ *   owner's inbox, a multi-producer queue drained by the owner once per tick, and the owner
+ *   is woken through its eventfd when the inbox was empty.
+ * - A client which used up its messages for the tick is not read until the next tick,
+ *   pendingReads lists those clients so the loop does not block while they wait.
+ */
+struct Shard
+{
+	// A line forwarded by another shard, resolved by the owner when the inbox is drained
+	struct Delivery
+	{
+		ClientHandle	client;
+		MessageBlock	message;
+		bool			droppable;
+	};
+
+	unsigned								index;
+	int										listener;
+	int										wakeFd;
+	std::unique_ptr<Poller>					poller;
+	std::vector<PollEvent>					readyEvents;
+	std::vector<int>						pendingDisconnects;
+	std::vector<int>						pendingSends;
+	std::vector<Client*>					pendingReads;
+	std::vector<Client*>					resumingReads;
+	std::mutex								inboxMutex;
+	std::vector<Delivery>					inbox;
+	std::vector<Delivery>					delivering;
+	std::atomic<bool>						inboxEvent;
+	TimerWheel								timers;
+	std::vector<TimerWheel::Timer>			expiredTimers;
+	uint32_t								timerSequence;
+	uint64_t								tick;
+	std::minstd_rand						random;
+	std::chrono::steady_clock::time_point	lastMetricsReport;
+	ScratchArena							scratch;
+	std::thread								thread;
+
+	explicit Shard( unsigned shardIndex );
+	~Shard();
+
+	Shard( const Shard& )				= delete;
+	Shard& operator=( const Shard& )	= delete;
+
+	void	wake		() noexcept;
+	void	clearWake	() noexcept;
+	void	forward		( ClientHandle client, const MessageBlock& message, bool droppable );
+	bool	takeInbox	();
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Hierarchical timing wheel holding client deadlines for one shard.
+ *
+ * Level 0 has irc::TIMER_RESOLUTION_MILLIS wide slots, every higher level covers the whole
+ * level below it per slot. A timer sits in the level matching how far away it is and is
+ * cascaded one level down when its slot comes up, so scheduling and expiry are constant time
+ * and only due timers are ever touched.
+ *
+ * Timers cannot be cancelled. The owner tags each one with an id and ignores expired timers
+ * whose id is no longer current.
+ */
+class TimerWheel
+{
+	public:
+		using clock			= std::chrono::steady_clock;
+		using time_point	= clock::time_point;
+
+		struct Timer
+		{
+			int			fd;
+			uint32_t	id;
+			uint64_t	expiry;
+		};
+
+	private:
+		static constexpr unsigned	LEVELS		= 4;
+		static constexpr unsigned	SLOT_BITS	= 6;
+		static constexpr unsigned	SLOTS		= 1U << SLOT_BITS;
+		static constexpr uint64_t	SLOT_MASK	= SLOTS - 1;
+
+		std::array<std::array<std::vector<Timer>, SLOTS>, LEVELS>	_levels;
+		time_point													_origin;
+		uint64_t													_current;
+		size_t														_size;
+
+		uint64_t	toTicks		( const time_point& time ) const noexcept;
+		void		insert		( const Timer& timer );
+		void		cascade		( unsigned level );
+
+	public:
+		TimerWheel();
+
+		void	schedule		( int fd, uint32_t id, const time_point& deadline );
+		void	advance			( const time_point& now, std::vector<Timer>& expired );
+		int		nextTimeout		( const time_point& now, int maxMillis ) const;
+		size_t	size			() const noexcept;
+};
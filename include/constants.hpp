@@ -19,10 +19,78 @@ namespace irc
 	constexpr const int CLIENT_PING_TIMEOUT = 120;
 	constexpr const int CLIENT_PING_INTERVAL = CLIENT_PING_TIMEOUT / 2;
 
-	// How often we should check for timeouts
+	// Keepalive PINGs are spread over this much time past the interval (milliseconds)
+	constexpr const int CLIENT_PING_JITTER_MILLIS = CLIENT_PING_INTERVAL * 1000 / 4;
+
+	// Longest the event loop sleeps without a due timer, also the queue metrics interval
 	constexpr const int TIMEOUT_INTERVAL = 30;
 	constexpr const int TIMEOUT_INTERVAL_MILLIS = TIMEOUT_INTERVAL * 1000;
 
+	// Tick length of the timer wheel holding the client deadlines (milliseconds)
+	constexpr const int TIMER_RESOLUTION_MILLIS = 10;
+
+
+	/*================ EVENT LOOP CONFIG ================*/
+	// Event backend: "epoll", "io_uring" or "poll". Unavailable backends fall back to poll
+	constexpr const char* const EVENT_BACKEND = "epoll";
+
+	// Environment variable which overrides EVENT_BACKEND at startup
+	constexpr const char* const EVENT_BACKEND_ENV = "IRCSERV_EVENT_BACKEND";
+
+	// Number of event loop threads, each with its own SO_REUSEPORT listener. 0 uses one per core
+	constexpr const unsigned REACTOR_THREADS = 0;
+
+	// Environment variable which overrides REACTOR_THREADS at startup
+	constexpr const char* const REACTOR_THREADS_ENV = "IRCSERV_THREADS";
+
+	// Maximum connections accepted from the backlog per loop tick
+	constexpr const size_t ACCEPT_BATCH_LIMIT = 64;
+
+	// Flood cost a client may spend per loop tick, each command costs its floodCost from the
+	// dispatch table. Messages past the budget wait for the next tick
+	constexpr const unsigned CLIENT_FLOOD_BUDGET = 64;
+
+	// Initial number of ready events fetched per wait (grows on demand)
+	constexpr const int MAX_POLL_EVENTS = 256;
+
+	// Maximum queued messages gathered into one write when flushing a client
+	constexpr const size_t MAX_SEND_VECTORS = 64;
+
+	// io_uring submission queue size
+	constexpr const unsigned IO_URING_ENTRIES = 1024;
+
+	// Provided receive buffers shared by all io_uring clients
+	constexpr const unsigned IO_URING_BUFFER_COUNT = 1024;
+	constexpr const unsigned IO_URING_BUFFER_SIZE = 4096;
+
+	// Delay before an io_uring accept which failed, for example at the descriptor limit, is queued again
+	constexpr const int IO_URING_ACCEPT_RETRY_MILLIS = 100;
+
+	// Per-thread scratch arena for the strings a command builds, released after every command and tick
+	constexpr const size_t SCRATCH_ARENA_SIZE = 64 * 1024;
+
+
+	/*================ BACKPRESSURE CONFIG ================*/
+	// What happens to a client which stays congested for longer than SLOW_CONSUMER_TIMEOUT
+	// DROP_LOW_PRIORITY:	channel chatter is no longer queued for it until it recovers
+	// PAUSE_READS:			its own socket is not read while its queue is above the high watermark
+	// DISCONNECT:			the client is dropped
+	enum class SlowConsumerAction { DROP_LOW_PRIORITY, PAUSE_READS, DISCONNECT };
+	constexpr const SlowConsumerAction SLOW_CONSUMER_ACTION = SlowConsumerAction::DROP_LOW_PRIORITY;
+
+	// A send queue above the high watermark is congested, it recovers at or below the low watermark
+	constexpr const size_t SEND_QUEUE_HIGH_WATERMARK = 64 * 1024;
+	constexpr const size_t SEND_QUEUE_LOW_WATERMARK = 16 * 1024;
+
+	// Hard memory budget of a single send queue, a client exceeding it is always disconnected
+	constexpr const size_t MAX_CLIENT_SEND_QUEUE_SIZE = 1024 * 1024;
+
+	// How long a client may stay congested before it is a slow consumer (seconds)
+	constexpr const int SLOW_CONSUMER_TIMEOUT = 10;
+
+	// Log the send queue depth of every shard each timeout check
+	constexpr const bool ENABLE_QUEUE_METRICS = true;
+
 
 	/*================ SERVER CONFIG ================*/
 	// Available channel modes
@@ -73,7 +141,7 @@ namespace irc
 	constexpr const size_t MAX_HOSTNAME_LENGTH = 64;
 
 	// Backlog value for listen. System maximum is 4096
-	constexpr const int MAX_CONNECTION_REQUESTS = 128;
+	constexpr const int MAX_CONNECTION_REQUESTS = 4096;
 
 	// Buffer size as defined in the IRC protocol
 	constexpr const size_t MAX_IRC_MESSAGE_LENGTH = 512;
@@ -81,6 +149,14 @@ namespace irc
 	// Maximum incomplete message buffer size
 	constexpr const int MAX_CLIENT_BUFFER_SIZE = 4096;
 
+	// Per-client buffer the socket is read into, a single read takes up to this much
+	constexpr const size_t CLIENT_RECEIVE_BUFFER_SIZE = 8192;
+	static_assert( CLIENT_RECEIVE_BUFFER_SIZE >= MAX_CLIENT_BUFFER_SIZE + MAX_IRC_MESSAGE_LENGTH,
+		"A client at the incomplete message limit must still fit a whole read" );
+
+	// Largest block the object pool keeps for reuse, client and channel storage up to a receive buffer
+	constexpr const size_t OBJECT_POOL_LARGEST_BLOCK = CLIENT_RECEIVE_BUFFER_SIZE;
+
 	// Should the server notify user on hostname lookup
 	constexpr const bool ANNOUNCE_CLIENT_LOOKUP = true;
 
@@ -89,6 +165,9 @@ namespace irc
 	constexpr const char* const CLIENT_HOSTNAME_FAILURE_MESSAGE = "Couldn't look up your hostname";
 	constexpr const char* const CLIENT_HOSTNAME_SUCCESS_MESSAGE = "Hostname retrieved";
 
+	// QUIT reason announced to channel members when a connection drops without a QUIT
+	constexpr const char* const CLIENT_CONNECTION_CLOSED_REASON = "Connection closed";
+
 
 	/*================ LOGGING CONFIG ================*/
 	// Logging constants
@@ -104,7 +183,7 @@ namespace irc
 
 	// Macros
 	inline void print( const auto& msg ) { std::cout << msg << '\n'; }
-	inline void log_event( const std::string& func, const std::string& status, const std::string& msg )
+	inline void log_event( std::string_view func, std::string_view status, std::string_view msg )
 	{
 		Logger::instance().log( func, status, msg );
 	}
@@ -23,5 +23,8 @@
  * netinet/in    | inet_addr, inet_ntoa
  * sys/stat      | fstat
  * poll          | poll
+ * sys/epoll     | epoll_create1, epoll_ctl, epoll_wait
+ * linux/io_uring| io_uring_setup, io_uring_enter (raw syscalls)
+ * sys/eventfd   | eventfd
  *
  */
@@ -0,0 +1,102 @@
+#include "ByteScan.hpp"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+# define IRC_BYTE_SCAN_X86
+#endif
+
+namespace
+{
+	using FindByte = const char* (*)( const char*, const char*, char ) noexcept;
+
+	const char*	findByteScalar( const char* begin, const char* end, char byte ) noexcept
+	{
+		while ( begin < end && *begin != byte )
+			++begin;
+		return begin;
+	}
+
+#ifdef IRC_BYTE_SCAN_X86
+	__attribute__((target("sse2")))
+	const char*	findByteSse2( const char* begin, const char* end, char byte ) noexcept
+	{
+		const __m128i	needle = _mm_set1_epi8( byte );
+
+		for ( ; end - begin >= 16; begin += 16 )
+		{
+			__m128i		chunk	= _mm_loadu_si128( reinterpret_cast<const __m128i*>( begin ) );
+			unsigned	mask	= _mm_movemask_epi8( _mm_cmpeq_epi8( chunk, needle ) );
+
+			if ( mask != 0 )
+				return ( begin + __builtin_ctz( mask ) );
+		}
+		return ( findByteScalar( begin, end, byte ) );
+	}
+
+	__attribute__((target("avx2")))
+	const char*	findByteAvx2( const char* begin, const char* end, char byte ) noexcept
+	{
+		const __m256i	needle = _mm256_set1_epi8( byte );
+
+		// Two vectors per iteration, so a long line costs one branch per 64 bytes
+		for ( ; end - begin >= 64; begin += 64 )
+		{
+			__m256i		low		= _mm256_loadu_si256( reinterpret_cast<const __m256i*>( begin ) );
+			__m256i		high	= _mm256_loadu_si256( reinterpret_cast<const __m256i*>( begin + 32 ) );
+			uint64_t	mask	= static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( low, needle ) ) )
+				| static_cast<uint64_t>( static_cast<uint32_t>( _mm256_movemask_epi8( _mm256_cmpeq_epi8( high, needle ) ) ) ) << 32;
+
+			if ( mask != 0 )
+				return ( begin + __builtin_ctzll( mask ) );
+		}
+		if ( end - begin >= 32 )
+		{
+			__m256i		chunk	= _mm256_loadu_si256( reinterpret_cast<const __m256i*>( begin ) );
+			uint32_t	mask	= _mm256_movemask_epi8( _mm256_cmpeq_epi8( chunk, needle ) );
+
+			if ( mask != 0 )
+				return ( begin + __builtin_ctz( mask ) );
+			begin += 32;
+		}
+		return ( findByteSse2( begin, end, byte ) );
+	}
+#endif
+
+	struct Kernel
+	{
+		FindByte	find;
+		const char*	name;
+	};
+
+	Kernel	selectKernel() noexcept
+	{
+#ifdef IRC_BYTE_SCAN_X86
+		__builtin_cpu_init();
+		if ( __builtin_cpu_supports( "avx2" ) )
+			return { findByteAvx2, "avx2" };
+		if ( __builtin_cpu_supports( "sse2" ) )
+			return { findByteSse2, "sse2" };
+#endif
+		return { findByteScalar, "scalar" };
+	}
+
+	const Kernel	kernel = selectKernel();
+}
+
+/**
+ * @brief Finds the first occurrence of byte in [begin, end).
+ * @return Pointer to the byte, or end when it does not occur.
+ */
+const char*	irc::findByte( const char* begin, const char* end, char byte ) noexcept
+{
+	return ( kernel.find( begin, end, byte ) );
+}
+
+/**
+ * @brief Name of the kernel selected for this CPU, for the startup log.
+ */
+const char*	irc::byteScanKernel() noexcept
+{
+	return ( kernel.name );
+}
@@ -1,8 +1,14 @@
 #include "Channels.hpp"
 #include "constants.hpp"
 
-Channel::Channel(const std::string& name) :
-	_name(name),
+Channel::Channel(std::string_view name, ChannelId id, std::pmr::memory_resource* resource) :
+	_name(name, resource),
+	_id(id),
+	_topic(resource),
+	_key(resource),
+	_members(resource),
+	_memberIndex(resource),
+	_invited(resource),
 	_inviteOnly(false),
 	_topicLocked(false),
 	_userLimit(irc::MAX_CHANNELS)
@@ -10,11 +16,12 @@ Channel::Channel(const std::string& name) :
 
 //Getters
 
-const	std::string&				Channel::getName		()	const	{ return _name; }
-const	std::string&				Channel::getTopic		()	const	{ return _topic; }
-const	std::string&				Channel::getKey			()	const	{ return _key; }
-const	std::unordered_set<int>&	Channel::getMembers		()	const	{ return _members; }
-const	std::unordered_set<int>&	Channel::getOperators	()	const	{ return _operators; }
+const	std::pmr::string&			Channel::getName		()	const	{ return _name; }
+ChannelId							Channel::getId			()	const	{ return _id; }
+const	std::pmr::string&			Channel::getTopic		()	const	{ return _topic; }
+const	std::pmr::string&			Channel::getKey			()	const	{ return _key; }
+const	std::pmr::vector<Channel::Member>&	Channel::getMembers		()	const	{ return _members; }
+const	Channel::InviteSet&			Channel::getInvited		()	const	{ return _invited; }
 bool								Channel::isInviteOnly	()	const	{ return _inviteOnly; }
 bool								Channel::isTopicLocked	()	const	{ return _topicLocked; }
 int									Channel::getUserLimit	()	const	{ return _userLimit; }
@@ -22,47 +29,81 @@ int									Channel::getUserLimit	()	const	{ return _userLimit; }
 
 //Setters
 
-void	Channel::setTopic(const std::string& topic)						{ _topic = topic;}
-void	Channel::setKey(const std::string& key)							{ _key = key; }
+void	Channel::setTopic(std::string_view topic)						{ _topic = topic;}
+void	Channel::setKey(std::string_view key)							{ _key = key; }
 void	Channel::setInviteOnly(bool inviteonly)							{ _inviteOnly = inviteonly; }
 void	Channel::setTopicLocked(bool topiclocked)						{ _topicLocked = topiclocked; }
 void	Channel::setUserLimit(size_t limit)								{ _userLimit = limit; }
 
 //Membership management
 
-// If clientFd was not already in _members, it is added, and the function returns true.
-// If clientFd was already in _members, nothing changes, and the function returns false.
-bool	Channel::addMember(int clientFd)
+Channel::Member*	Channel::findMember(ClientHandle client)
 {
-	auto result = _members.insert(clientFd);// The insert method returns a std::pair (std::pair<iterator, bool> insert(const value_type& value);)
-	return result.second;
+	auto it = _memberIndex.find(client);
+	return it != _memberIndex.end() ? &_members[it->second] : nullptr;
 }
 
-bool	Channel::addOperator(int clientFd)
+const Channel::Member*	Channel::findMember(ClientHandle client) const
 {
-	auto result = _operators.insert(clientFd);
-	return result.second;
+	auto it = _memberIndex.find(client);
+	return it != _memberIndex.end() ? &_members[it->second] : nullptr;
 }
 
-void	Channel::removeMember(int clientFd)							{ _members.erase(clientFd); }
-void	Channel::removeOperator(int clientFd)						{ _operators.erase(clientFd); }
-// If clientFd is present, the iterator returned will not be equal to _operators.end() and the function returns true.
-// If clientFd is not present, the iterator will be equal to _operators.end() and the function returns false.
-bool	Channel::isOperator(int clientFd)							{ return _operators.find(clientFd) != _operators.end(); }
-void	Channel::invite(int clientFd)								{ _invited.insert(clientFd); }
-bool	Channel::isInvited(int clientFd)							{ return _invited.find(clientFd) != _invited.end(); }
-void	Channel::removeInvite(int clientFd)							{ _invited.erase(clientFd); }
+// If client was not already a member, it is appended to _members, and the function returns true.
+// If client was already a member, nothing changes, and the function returns false.
+bool	Channel::addMember(ClientHandle client)
+{
+	auto result = _memberIndex.try_emplace(client, static_cast<uint32_t>(_members.size()));
+	if (!result.second)
+		return false;
+	_members.push_back({client, 0});
+	return true;
+}
 
-// Helpers
+// Only members can be operators, the function returns false if client is not a member or already an operator.
+bool	Channel::addOperator(ClientHandle client)
+{
+	Member* member = findMember(client);
+	if (!member || member->isOperator())
+		return false;
+	member->flags |= MEMBER_OPERATOR;
+	return true;
+}
 
-bool	Channel::isFull() const										{ return _userLimit > 0 && _members.size() >= static_cast<size_t>(_userLimit); }
-bool	Channel::isEmpty() const									{ return _members.empty(); }
-bool	Channel::isMember(int clientFd) const
+// The last member takes the place of the removed one, so removal does not shift the array.
+void	Channel::removeMember(ClientHandle client)
 {
-	for (auto& it : _members)
+	auto it = _memberIndex.find(client);
+	if (it == _memberIndex.end())
+		return ;
+
+	uint32_t position = it->second;
+	_memberIndex.erase(it);
+	if (position != _members.size() - 1)
 	{
-		if (it == clientFd)
-			return true;
+		_members[position] = _members.back();
+		_memberIndex[_members[position].client] = position;
 	}
-	return false;
+	_members.pop_back();
 }
+
+void	Channel::removeOperator(ClientHandle client)
+{
+	if (Member* member = findMember(client))
+		member->flags &= ~MEMBER_OPERATOR;
+}
+
+bool	Channel::isOperator(ClientHandle client) const
+{
+	const Member* member = findMember(client);
+	return member && member->isOperator();
+}
+void	Channel::invite(ClientHandle client)							{ _invited.insert(client); }
+bool	Channel::isInvited(ClientHandle client)							{ return _invited.find(client) != _invited.end(); }
+void	Channel::removeInvite(ClientHandle client)						{ _invited.erase(client); }
+
+// Helpers
+
+bool	Channel::isFull() const										{ return _userLimit > 0 && _members.size() >= static_cast<size_t>(_userLimit); }
+bool	Channel::isEmpty() const									{ return _members.empty(); }
+bool	Channel::isMember(ClientHandle client) const				{ return _memberIndex.find(client) != _memberIndex.end(); }
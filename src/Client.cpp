@@ -1,5 +1,6 @@
 #include "Client.hpp"
 #include "constants.hpp"
+#include <algorithm>
 
 // Type definitions
 using steady_clock	= std::chrono::steady_clock;
@@ -7,18 +8,48 @@ using time_point	= std::chrono::steady_clock::time_point;
 
 // Constructor/Destructor
 
-Client::Client() :
+// The strings, invites and buffers take their storage from resource, the server passes its object pool
+Client::Client( std::pmr::memory_resource* resource ) :
 	_clientFd(-1),
+	_shard(nullptr),
+	_username(resource),
+	_hostname(resource),
+	_servername(resource),
+	_nickname(resource),
+	_realname(resource),
+	_prefix(resource),
 	_authenticated(false),
+	_channels(),
+	_channelCount(0),
+	_invites(resource),
+	_quitReason(irc::CLIENT_CONNECTION_CLOSED_REASON, resource),
+	_receiveBuffer(resource),
+	_sendQueue(resource),
+	_sendOffset(0),
+	_sendQueueSize(0),
+	_sendQueued(false),
+	_slowConsumer(false),
+	_readsPaused(false),
+	_readsDeferred(false),
+	_reading(true),
+	_budgetTick(0),
+	_budgetSpent(0),
+	_droppedMessages(0),
+	_ipAddress(resource),
 	_clientAddress({}),
 	_passwordAttempts(0),
 	_passValidated(false),
 	_active(true),
 	_pollout(false),
+	_sendInFlight(false),
 	_connectionTime(steady_clock::now()),
 	_lastActivity(steady_clock::now()),
-	_pingPending(false)
-{}
+	_pingPending(false),
+	_congestedSince(),
+	_timerId(0)
+{
+	updatePrefix();
+}
 
 Client::~Client() {}
 
@@ -26,163 +57,290 @@ Client::~Client() {}
 // Getters
 
 int									Client::getFd				() const noexcept	{ return _clientFd; }
-const std::string&					Client::getUsername			() const noexcept	{ return _username; }
-const std::string&					Client::getHostname			() const noexcept	{ return _hostname; }
-const std::string&					Client::getServername		() const noexcept	{ return _servername; }
-const std::string&					Client::getNickname			() const noexcept	{ return _nickname; }
-const std::string&					Client::getRealname			() const noexcept	{ return _realname; }
-const std::string&					Client::getReceiveBuffer	() const noexcept	{ return _receiveBuffer; }
-const std::string&					Client::getSendBuffer		() const noexcept	{ return _sendBuffer; }
-const std::string&					Client::getIpAddress		() const noexcept	{ return _ipAddress; }
+ClientHandle						Client::getHandle			() const noexcept	{ return _handle; }
+Shard*								Client::getShard			() const noexcept	{ return _shard; }
+const std::pmr::string&				Client::getUsername			() const noexcept	{ return _username; }
+const std::pmr::string&				Client::getHostname			() const noexcept	{ return _hostname; }
+const std::pmr::string&				Client::getServername		() const noexcept	{ return _servername; }
+const std::pmr::string&				Client::getNickname			() const noexcept	{ return _nickname; }
+const std::pmr::string&				Client::getRealname			() const noexcept	{ return _realname; }
+const std::pmr::string&				Client::getPrefix			() const noexcept	{ return _prefix; }
+ReceiveBuffer&						Client::getReceiveBuffer	() noexcept			{ return _receiveBuffer; }
+size_t								Client::getSendQueueSize	() const noexcept	{ return _sendQueueSize; }
+bool								Client::getSendQueued		() const noexcept	{ return _sendQueued; }
+bool								Client::getSlowConsumer		() const noexcept	{ return _slowConsumer; }
+bool								Client::getReadsPaused		() const noexcept	{ return _readsPaused; }
+bool								Client::getReadsDeferred	() const noexcept	{ return _readsDeferred; }
+bool								Client::getReading			() const noexcept	{ return _reading; }
+size_t								Client::getDroppedMessages	() const noexcept	{ return _droppedMessages; }
+const std::pmr::string&				Client::getIpAddress		() const noexcept	{ return _ipAddress; }
 sockaddr&							Client::getClientAddress	()					{ return _clientAddress; }
 bool								Client::isAuthenticated		() const			{ return _authenticated; }
-std::unordered_set<std::string>&	Client::getChannels			()					{ return _channels; }
+std::span<const ChannelId>			Client::getChannels			() const noexcept	{ return { _channels.data(), _channelCount }; }
+std::span<const ChannelId>			Client::getInvites			() const noexcept	{ return _invites; }
+const std::pmr::string&				Client::getQuitReason		() const noexcept	{ return _quitReason; }
 int									Client::getPasswordAttempts	() const noexcept	{ return _passwordAttempts; }
 bool								Client::getPassValidated	() const noexcept	{ return _passValidated; }
 bool								Client::getActive			() const noexcept	{ return _active; }
 bool								Client::getPollout			() const noexcept	{ return _pollout; }
+bool								Client::getSendInFlight		() const noexcept	{ return _sendInFlight; }
+size_t								Client::getSendOffset		() const noexcept	{ return _sendOffset; }
 const time_point&					Client::getConnectionTime	() const noexcept	{ return _connectionTime; }
 const time_point&					Client::getLastActivity		() const noexcept	{ return _lastActivity; }
 const time_point&					Client::getLastPing			() const noexcept	{ return _lastPing; }
 bool								Client::getPingPending		() const noexcept	{ return _pingPending; }
+uint32_t							Client::getTimerId			() const noexcept	{ return _timerId; }
 
 
 // Setters
 
 void	Client::setClientFd			( int fd )							{ _clientFd = fd; }
-void	Client::setUsername			( const std::string& username )		{ _username = username; }
-void	Client::setHostname			( const std::string& hostname )		{ _hostname = hostname; }
-void	Client::setServername		( const std::string& servername )	{ _servername = servername; }
-void	Client::setNickname			( const std::string& nickname )		{ _nickname = nickname; }
-void	Client::setRealname			( const std::string& realname )		{ _realname = realname; }
-void	Client::setIpAddress		( const std::string& address )		{ _ipAddress = address; }
+void	Client::setHandle			( ClientHandle handle )				{ _handle = handle; }
+void	Client::setShard			( Shard* shard )					{ _shard = shard; }
+void	Client::setUsername			( std::string_view username )		{ _username = username; updatePrefix(); }
+void	Client::setHostname			( std::string_view hostname )		{ _hostname = hostname; updatePrefix(); }
+void	Client::setServername		( std::string_view servername )		{ _servername = servername; }
+void	Client::setNickname			( std::string_view nickname )		{ _nickname = nickname; updatePrefix(); }
+void	Client::setRealname			( std::string_view realname )		{ _realname = realname; }
+void	Client::setIpAddress		( std::string_view address )		{ _ipAddress = address; updatePrefix(); }
 void	Client::setClientAddress	( sockaddr address )				{ _clientAddress = address; }
 void	Client::setAuthenticated	( bool auth )						{ _authenticated = auth; }
-void	Client::setReceiveBuffer	( const std::string& buffer )		{ _receiveBuffer = buffer; }
-void	Client::setSendBuffer		( const std::string& buffer )		{ _sendBuffer = buffer; }
 void	Client::setPasswordAttempts	( int attempts )					{ _passwordAttempts = attempts; }
 void	Client::setPassValidated	( bool valid )						{ _passValidated = valid; }
 void	Client::setActive			( bool active )						{ _active = active; }
 void	Client::setPollout			( bool required )					{ _pollout = required; }
+void	Client::setSendInFlight		( bool inFlight )					{ _sendInFlight = inFlight; }
+void	Client::setSendQueued		( bool queued )						{ _sendQueued = queued; }
+void	Client::setSlowConsumer		( bool slow )						{ _slowConsumer = slow; }
+void	Client::setReadsPaused		( bool paused )						{ _readsPaused = paused; }
+void	Client::setReadsDeferred	( bool deferred )					{ _readsDeferred = deferred; }
+void	Client::setReading			( bool reading )					{ _reading = reading; }
 void	Client::setConnectionTime	( const time_point& time )			{ _connectionTime = time; }
 void	Client::setLastActivity		( const time_point& time )			{ _lastActivity = time; }
 void	Client::setLastPing			( const time_point& time )			{ _lastPing = time; }
 void	Client::setPingPending		( bool pending )					{ _pingPending = pending; }
+void	Client::setTimerId			( uint32_t id )						{ _timerId = id; }
+void	Client::setQuitReason		( std::string_view reason )		{ _quitReason = reason; }
+
+/**
+ * @brief Rebuilds the nick!user@host source of relayed commands, so relaying a command
+ * costs no string work. Called by every setter of a part of it.
+ * The IP address replaces the given hostname when irc::REVEAL_HOSTNAME is set.
+ */
+void	Client::updatePrefix()
+{
+	const std::pmr::string&	host = ( irc::REVEAL_HOSTNAME && !_ipAddress.empty() ) ? _ipAddress : _hostname;
+
+	_prefix.clear();
+	_prefix.reserve( _nickname.length() + _username.length() + host.length() + 2 );
+	_prefix.append( _nickname.empty() ? "*" : _nickname ).append( 1, '!' ).append( _username ).append( 1, '@' ).append( host );
+}
 
 
 // Buffer management
 
 /**
- * @brief Appends incomplete data to the client's receiving buffer.
- * Will check that the buffer limit is never exceeded.
- * @return true on successful operation, otherwise false (client should disconnect)
+ * @brief Queues an outgoing message. Nothing is written here, the owning shard flushes
+ * the whole queue with one gathered write at the end of its loop tick.
+ * Only a reference is stored, so a broadcast line is never copied per recipient.
+ *
+ * Crossing the high watermark starts the congestion clock. Droppable messages are discarded
+ * instead of queued while the client is a slow consumer and the configured action drops them.
+ * @return true on successful operation, otherwise false (over budget, client should disconnect)
  */
-bool	Client::appendToReceiveBuffer(const std::string& data)
+bool	Client::appendToSendBuffer(const MessageBlock& message, bool droppable)
 {
-	if ( _receiveBuffer.length() + data.length() > irc::MAX_CLIENT_BUFFER_SIZE )
+	if ( droppable && _slowConsumer && irc::SLOW_CONSUMER_ACTION == irc::SlowConsumerAction::DROP_LOW_PRIORITY )
+	{
+		++_droppedMessages;
+		return true;
+	}
+	if ( _sendQueueSize + message->length() > irc::MAX_CLIENT_SEND_QUEUE_SIZE )
 	{
-		irc::log_event( "PROTOCOL VIOLATION", irc::LOG_FAIL, "exceeded maximum buffer length limit" );
+		irc::log_event( "PROTOCOL VIOLATION", irc::LOG_FAIL, "exceeded maximum send queue size" );
 		return false;
 	}
-	_receiveBuffer += data;
+	_sendQueue.push_back( message );
+	_sendQueueSize += message->length();
+	if ( _sendQueueSize > irc::SEND_QUEUE_HIGH_WATERMARK && _congestedSince == time_point() )
+		_congestedSince = steady_clock::now();
 	return true;
 }
-bool	Client::appendToSendBuffer(const std::string& data)
+
+void	Client::clearReceiveBuffer		()			{ _receiveBuffer.clear(); }
+void	Client::clearSendBuffer			()			{ _sendQueue.clear(); _sendOffset = 0; _sendQueueSize = 0; _congestedSince = time_point(); }
+bool	Client::hasPendingOutput		() const noexcept	{ return _sendQueueSize != 0; }
+
+/**
+ * @brief Describes the front of the send queue as an iovec array for writev/sendmsg.
+ * The first vector starts past the bytes already written from the front message.
+ *
+ * @return Number of vectors filled, at most count.
+ */
+size_t	Client::fillSendVector( iovec* vectors, size_t count ) const
 {
-	if ( _sendBuffer.length() + data.length() > irc::MAX_CLIENT_BUFFER_SIZE )
+	size_t	filled = 0;
+	size_t	offset = _sendOffset;
+
+	for ( auto it = _sendQueue.begin(); it != _sendQueue.end() && filled < count; ++it )
 	{
-		irc::log_event( "PROTOCOL VIOLATION", irc::LOG_FAIL, "exceeded maximum buffer length limit" );
-		return false;
+		vectors[filled].iov_base	= const_cast<char*>( (*it)->data() + offset );
+		vectors[filled].iov_len		= (*it)->length() - offset;
+		offset = 0;
+		++filled;
 	}
-	_sendBuffer += data;
-	return true;
+	return filled;
 }
 
-void	Client::clearReceiveBuffer		()			{ _receiveBuffer.clear(); }
-void	Client::clearSendBuffer			()			{ _sendBuffer.clear(); }
+/**
+ * @brief Copies the references at the front of the send queue, for a backend which
+ * writes on its own and must keep the messages alive until the write completes.
+ * The first block is still written from getSendOffset.
+ *
+ * @return Number of blocks filled, at most count.
+ */
+size_t	Client::fillSendBlocks( MessageBlock* blocks, size_t count ) const
+{
+	size_t	filled = 0;
+
+	for ( auto it = _sendQueue.begin(); it != _sendQueue.end() && filled < count; ++it )
+		blocks[filled++] = *it;
+	return filled;
+}
 
 /**
- * @brief Checks if the receive buffer contains a complete message
- * @return true if \\r\\n is found in the buffer, false otherwise
+ * @brief Drops bytes which were written to the socket from the front of the send queue.
+ * Draining to the low watermark ends the congestion.
  */
-bool	Client::isReceiveBufferComplete	() const	{ return _receiveBuffer.find("\r\n") != std::string::npos; }
-bool	Client::isSendBufferComplete	() const	{ return _sendBuffer.find("\r\n") != std::string::npos; }
+void	Client::consumeSendBuffer( size_t bytes )
+{
+	_sendQueueSize -= bytes;
+	if ( _sendQueueSize <= irc::SEND_QUEUE_LOW_WATERMARK )
+		_congestedSince = time_point();
+	while ( bytes > 0 && !_sendQueue.empty() )
+	{
+		size_t remaining = _sendQueue.front()->length() - _sendOffset;
+
+		if ( bytes < remaining )
+		{
+			_sendOffset += bytes;
+			return ;
+		}
+		bytes -= remaining;
+		_sendOffset = 0;
+		_sendQueue.pop_front();
+	}
+}
 
 /**
- * @brief Extracting and returning one complete IRC command (without \\r\\n) from the receive buffer.
- * Also clears up the receive buffer if a complete message was found.
+ * @brief Checks the client's flood budget for the loop tick, which starts over on every tick.
  *
- * @return Complete message without \\r\\n when found. If no message or incomplete message then empty string.
+ * @return false once the commands executed this tick cost irc::CLIENT_FLOOD_BUDGET.
  */
-std::string Client::extractLineFromReceive()
+bool	Client::hasFloodBudget( uint64_t tick )
 {
-	size_t pos = _receiveBuffer.find("\r\n");
-	if (pos == std::string::npos)
-		return "";
-	std::string line = _receiveBuffer.substr(0, pos);
-	_receiveBuffer.erase(0, pos + 2);
-	return line;
+	if ( _budgetTick != tick )
+	{
+		_budgetTick		= tick;
+		_budgetSpent	= 0;
+	}
+	return _budgetSpent < irc::CLIENT_FLOOD_BUDGET;
 }
-std::string Client::extractLineFromSend()
+
+void	Client::spendFloodBudget( unsigned cost )	{ _budgetSpent += cost; }
+
+// Adds a channel to the channels the client has joined.
+// Duplicates and joins past CHANLIMIT are ignored, JOIN checks the limit before getting here.
+void	Client::joinChannel(ChannelId channel)
 {
-	size_t pos = _sendBuffer.find("\r\n");
-	if (pos == std::string::npos)
-		return "";
-	std::string line = _sendBuffer.substr(0, pos);
-	_sendBuffer.erase(0, pos + 2);
-	return line;
+	if (_channelCount == _channels.size() || isInChannel(channel))
+		return ;
+	_channels[_channelCount++] = channel;
 }
 
-// Adds a channel to the set of channels the client has joined.
-// No duplicates are possible due to unordered_set.
-void	Client::joinChannel(const std::string& channel)
+// The last joined channel takes the place of the one left.
+void	Client::leaveChannel(ChannelId channel)
 {
-	_channels.insert(channel);
+	for (size_t idx = 0; idx < _channelCount; ++idx)
+	{
+		if (_channels[idx] == channel)
+		{
+			_channels[idx] = _channels[--_channelCount];
+			return ;
+		}
+	}
 }
 
-void	Client::leaveChannel(const std::string& channel)
+// A linear scan, a client is in at most irc::MAX_CHANNELS channels.
+bool	Client::isInChannel(ChannelId channel) const
 {
-	_channels.erase(channel);
+	for (size_t idx = 0; idx < _channelCount; ++idx)
+	{
+		if (_channels[idx] == channel)
+			return true;
+	}
+	return false;
 }
 
-// find(channel) returns an iterator to the channel if present, or channels.end() if not.
-// If not end(), the client is in the channel.
-bool	Client::isInChannel(const std::string& channel) const
+// Remembers the inviting channel, so disconnecting drops the invite without searching every channel.
+void	Client::addInvite(ChannelId channel)
 {
-	return _channels.find(channel) != _channels.end();
+	if (std::find(_invites.begin(), _invites.end(), channel) == _invites.end())
+		_invites.push_back(channel);
+}
+
+// Forgets a removed channel's invite, its id may be handed to the next channel created.
+void	Client::removeInvite(ChannelId channel)
+{
+	auto it = std::find(_invites.begin(), _invites.end(), channel);
+
+	if (it != _invites.end())
+	{
+		*it = _invites.back();
+		_invites.pop_back();
+	}
 }
 
 // Password authentication
 void	Client::incrementPassAttempts() { ++_passwordAttempts; }
 
 // Timeout checks
+// The current time is passed in, so the timer handling reads the clock once for all due clients
 
-
-bool	Client::hasRegistrationExpired()
+bool	Client::hasRegistrationExpired( const time_point& now ) const
 {
 	if ( _authenticated )
 		return false;
 
-	auto elapsed = std::chrono::duration_cast<std::chrono::seconds>( steady_clock::now() - _connectionTime );
-	return elapsed.count() >= irc::CLIENT_REGISTRATION_TIMEOUT;
+	return now - _connectionTime >= std::chrono::seconds( irc::CLIENT_REGISTRATION_TIMEOUT );
 }
 
-bool	Client::hasPingExpired()
+bool	Client::hasPingExpired( const time_point& now ) const
 {
 	if ( !_pingPending )
 		return false;
 
-	auto elapsed = std::chrono::duration_cast<std::chrono::seconds>( steady_clock::now() - _lastPing );
-	return elapsed.count() >= irc::CLIENT_PING_TIMEOUT;
+	return now - _lastPing >= std::chrono::seconds( irc::CLIENT_PING_TIMEOUT );
+}
+
+/**
+ * @brief Checks if the send queue has been above the high watermark for longer than irc::SLOW_CONSUMER_TIMEOUT.
+ */
+bool	Client::hasCongestionExpired() const
+{
+	if ( _congestedSince == time_point() )
+		return false;
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::seconds>( steady_clock::now() - _congestedSince );
+	return elapsed.count() >= irc::SLOW_CONSUMER_TIMEOUT;
 }
 
-bool	Client::needsPing()
+bool	Client::needsPing( const time_point& now ) const
 {
 	if ( !_authenticated || _pingPending )
 		return false;
 
-	auto elapsed = std::chrono::duration_cast<std::chrono::seconds>( steady_clock::now() - _lastActivity );
-	return elapsed.count() >= irc::CLIENT_PING_INTERVAL;
+	return now - _lastActivity >= std::chrono::seconds( irc::CLIENT_PING_INTERVAL );
 }
 
 void	Client::updateConnectionTime()	{ _connectionTime = steady_clock::now(); }
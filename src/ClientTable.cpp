@@ -0,0 +1,121 @@
+#include "ClientTable.hpp"
+
+/// Constructors and destructors
+
+ClientTable::ClientTable( std::pmr::memory_resource* resource ) :
+	_size( 0 ),
+	_resource( resource )
+{}
+
+
+/// Lookup
+
+/**
+ * @brief Slot of the descriptor, or nullptr when its page was never allocated.
+ */
+ClientTable::Slot*	ClientTable::slot( int fd ) const noexcept
+{
+	if ( fd < 0 || static_cast<size_t>( fd ) >= capacity() )
+		return ( nullptr );
+	return ( &_pages[fd / PAGE_SIZE][fd % PAGE_SIZE] );
+}
+
+Client*	ClientTable::find( int fd ) noexcept
+{
+	Slot* entry = slot( fd );
+
+	return ( entry && entry->client ) ? &*entry->client : nullptr;
+}
+
+const Client*	ClientTable::find( int fd ) const noexcept
+{
+	const Slot* entry = slot( fd );
+
+	return ( entry && entry->client ) ? &*entry->client : nullptr;
+}
+
+/**
+ * @brief The client the handle was made for, or nullptr when it is gone.
+ * A stale handle only costs a generation compare.
+ */
+Client*	ClientTable::find( ClientHandle handle ) noexcept
+{
+	Slot* entry = slot( handle.slot );
+
+	return ( entry && entry->client && entry->generation == handle.generation ) ? &*entry->client : nullptr;
+}
+
+const Client*	ClientTable::find( ClientHandle handle ) const noexcept
+{
+	const Slot* entry = slot( handle.slot );
+
+	return ( entry && entry->client && entry->generation == handle.generation ) ? &*entry->client : nullptr;
+}
+
+/**
+ * @brief Handle of the client currently stored under the descriptor.
+ */
+ClientHandle	ClientTable::handle( int fd ) const noexcept
+{
+	return { fd, generation( fd ) };
+}
+
+/**
+ * @brief Number of clients the descriptor's slot has held, the current one included.
+ */
+uint32_t	ClientTable::generation( int fd ) const noexcept
+{
+	const Slot* entry = slot( fd );
+
+	return ( entry ? entry->generation : 0 );
+}
+
+
+/// Modifiers
+
+/**
+ * @brief Stores a new client under the descriptor, its buffers using the table's memory resource,
+ * allocating the descriptor's page if needed. A client already stored there is replaced.
+ *
+ * @return The stored client, its address stays valid until it is erased.
+ */
+Client&	ClientTable::emplace( int fd )
+{
+	size_t	page = static_cast<size_t>( fd ) / PAGE_SIZE;
+
+	while ( _pages.size() <= page )
+		_pages.push_back( std::make_unique<Slot[]>( PAGE_SIZE ) );
+
+	Slot& entry = *slot( fd );
+
+	if ( !entry.client )
+		++_size;
+	++entry.generation;
+	return ( entry.client.emplace( _resource ) );
+}
+
+void	ClientTable::erase( int fd )
+{
+	Slot* entry = slot( fd );
+
+	if ( !entry || !entry->client )
+		return ;
+	entry->client.reset();
+	--_size;
+}
+
+/**
+ * @brief Removes every client and releases the pages.
+ */
+void	ClientTable::clear()
+{
+	_pages.clear();
+	_size = 0;
+}
+
+
+/// Bookkeeping
+
+size_t	ClientTable::size		() const noexcept	{ return _size; }
+size_t	ClientTable::capacity	() const noexcept	{ return _pages.size() * PAGE_SIZE; }
+bool	ClientTable::empty		() const noexcept	{ return _size == 0; }
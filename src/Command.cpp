@@ -1,70 +1,128 @@
 #include "Command.hpp"
-#include <algorithm>
+#include "ByteScan.hpp"
 
-/*Simple helper function to ensure commands
-  are always stored in uppercase format.*/
-static	std::string	stringToUpper(const std::string channelName)
+/* skipSpaces returns the position of the first non-space character at or after position.
+   Only the space character separates tokens, like in the IRC message grammar.*/
+
+static size_t	skipSpaces(std::string_view message, size_t position)
 {
-	std::string result = channelName;
-	std::transform(result.begin(), result.end(), result.begin(), ::toupper);
-	return result;
+	while (position < message.length() && message[position] == ' ')
+		++position;
+	return position;
 }
 
+/* nextToken returns the token starting at or after position as a view into the message,
+   and moves position to the separator right after it. The separator is found with the vectorized byte scan.*/
+
+static std::string_view	nextToken(std::string_view message, size_t& position)
+{
+	size_t	start = skipSpaces(message, position);
+	size_t	end = irc::findByte(message.data() + start, message.data() + message.length(), ' ') - message.data();
+
+	position = end;
+	return message.substr(start, end - start);
+}
 
-/* joinTrail will pick up the token where ':' was found,
-   and join it with the rest of the stringstream, which is picked up with std::getline.
-   if token is ":hello", and trail is "there friends", ":hello there friends" is returned.*/
+/* sameCommand compares the token to an uppercase command name, ignoring the case of the token.*/
 
-static  std::string joinTrail(std::string token, std::istringstream &iss)
+static bool	sameCommand(std::string_view token, std::string_view name)
 {
-	std::string trail;
+	for (size_t idx = 0; idx < name.length(); ++idx)
+	{
+		if ((token[idx] & ~0x20) != name[idx]) // Command names are letters only
+			return false;
+	}
+	return true;
+}
 
-	std::getline(iss, trail);
+/* commandType recognizes the command by its length first, so at most four names are compared.*/
 
-	return token.substr(1) + trail;
+static CommandType	commandType(std::string_view token)
+{
+	switch (token.length())
+	{
+		case 3:
+			if (sameCommand(token, "WHO"))		return CommandType::WHO;
+			break ;
+		case 4:
+			switch (token[0] & ~0x20)
+			{
+				case 'P':
+					if (sameCommand(token, "PASS"))	return CommandType::PASS;
+					if (sameCommand(token, "PART"))	return CommandType::PART;
+					if (sameCommand(token, "PING"))	return CommandType::PING;
+					if (sameCommand(token, "PONG"))	return CommandType::PONG;
+					break ;
+				case 'N':
+					if (sameCommand(token, "NICK"))	return CommandType::NICK;
+					break ;
+				case 'U':
+					if (sameCommand(token, "USER"))	return CommandType::USER;
+					break ;
+				case 'J':
+					if (sameCommand(token, "JOIN"))	return CommandType::JOIN;
+					break ;
+				case 'K':
+					if (sameCommand(token, "KICK"))	return CommandType::KICK;
+					break ;
+				case 'M':
+					if (sameCommand(token, "MODE"))	return CommandType::MODE;
+					break ;
+				case 'Q':
+					if (sameCommand(token, "QUIT"))	return CommandType::QUIT;
+					break ;
+			}
+			break ;
+		case 5:
+			if (sameCommand(token, "TOPIC"))	return CommandType::TOPIC;
+			if (sameCommand(token, "USERS"))	return CommandType::USERS;
+			if (sameCommand(token, "WHOIS"))	return CommandType::WHOIS;
+			break ;
+		case 6:
+			if (sameCommand(token, "NOTICE"))	return CommandType::NOTICE;
+			if (sameCommand(token, "INVITE"))	return CommandType::INVITE;
+			if (sameCommand(token, "SUMMON"))	return CommandType::SUMMON;
+			break ;
+		case 7:
+			if (sameCommand(token, "PRIVMSG"))	return CommandType::PRIVMSG;
+			break ;
+	}
+	return CommandType::UNKNOWN;
 }
 
-/* msgToCmd uses istringstream to tokenize the message.
-   The function recognizes the token as either prefix, command, or parameter.
-   If prefix is missing, first token is always the command portion of the message.
-   Command is always stored in uppercase, hence the stringToupper helper function.
-   If a trailing parameter is found, joinTrail joins rest of the stringstream into a single parameter.
-   Thus concluding the process and returning the finished cmd structure*/
+/* msgToCmd splits the message in a single pass, without copying or allocating.
+   The first token is the prefix when it starts with ':', the command follows it.
+   Every following token is a parameter. A parameter starting with ':' is the trailing parameter,
+   it takes the rest of the message as is, spaces included, and concludes the process.
+   The 15th parameter also takes the rest of the message, as the protocol allows no more.*/
 
-Command msgToCmd(std::string message)
+Command msgToCmd(std::string_view message)
 {
 	Command				cmd;
-	std::istringstream	iss(message);
-	std::string			token;
-	size_t				token_counter = 0;
+	size_t				position = 0;
+	std::string_view	token = nextToken(message, position);
 
-	while (iss >> token)
+	if (!token.empty() && token[0] == ':')
 	{
-		if (!token.empty() && token_counter == 0)
-		{
-			if (token[0] == ':')
-				cmd.prefix = token;
-			else
-				cmd.command = stringToUpper(token);
-		}
-		else if (!token.empty() && token_counter == 1)
+		cmd.prefix = token;
+		token = nextToken(message, position);
+	}
+	cmd.command = token;
+	cmd.type = commandType(token);
+
+	while ((position = skipSpaces(message, position)) < message.length())
+	{
+		if (message[position] == ':')
 		{
-			if (!cmd.prefix.empty())
-				cmd.command = stringToUpper(token);
-			else
-				cmd.params.push_back(token);
+			cmd.params.push_back(message.substr(position + 1));
+			break ;
 		}
-		else if (!token.empty())
+		if (cmd.params.size() == CommandParams::MAX_PARAMS - 1)
 		{
-			if (token[0] == ':')
-			{
-				cmd.params.push_back(joinTrail(token, iss));
-				return cmd;
-			}
-			else
-				cmd.params.push_back(token);
+			cmd.params.push_back(message.substr(position));
+			break ;
 		}
-		token_counter++;
+		cmd.params.push_back(nextToken(message, position));
 	}
 	return cmd;
 }
@@ -7,81 +7,84 @@
 #include "Command.hpp"
 #include "constants.hpp"
 
+// Type definitions
+using Field = Response::Field;
+
+/**
+ * @brief Queues one rendered line to every member of a channel. The line is shared,
+ * so each member only costs a reference pushed to its send queue.
+ *
+ * Runs under a shared state lock for PRIVMSG and NOTICE, so the channel is only read.
+ * Disconnect cleanup removes a client from its channels, a member whose client is gone is skipped.
+ *
+ * @param channel The channel whose members receive the line.
+ * @param line The rendered line, nothing is queued when it is empty.
+ * @param except Member who should not receive it, usually the sender. May be nullptr.
+ * @param droppable Low priority channel chatter, which a slow consumer may lose.
+ */
+void	CommandHandler::broadcastLine( Channel& channel, const MessageBlock& line, const Client* except, bool droppable )
+{
+	ClientTable&	allClients	= _server.getClients();
+
+	if ( !line )
+		return ;
+
+	for ( const Channel::Member& member : channel.getMembers() )
+	{
+		if ( except && member.client == except->getHandle() ) continue;
+
+		if ( Client* channelMember = allClients.find(member.client) )
+			Response::sendMessage(*channelMember, line, droppable);
+	}
+}
+
 /**
  * @brief Broadcast JOIN message to all members of a channel. Also outputs the list of NAMES to the client.
  */
 void	CommandHandler::broadcastJoin( Client& client, Channel& channel )
 {
-	const std::string	channelName	= channel.getName();
-	const auto&			allClients	= _server.getClients();
-	std::string			namesList;
+	const std::pmr::string&	channelName	= channel.getName();
+	const ClientTable&		allClients	= _server.getClients();
+	irc::ScratchString		namesList(irc::scratch());
 
 	if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
-		irc::log_event("CHANNEL", irc::LOG_DEBUG, "broadcast: " + channelName);
+		irc::log_event("CHANNEL", irc::LOG_DEBUG, irc::concat("broadcast: ", channelName));
 
 	// Announce new channel member to all existing clients
-	for ( const auto memberFd : channel.getMembers() )
+	broadcastLine(channel, Response::renderCommand(CommandType::JOIN, client, {{Field::CHANNEL, channelName}}), nullptr, false);
+
+	for ( const Channel::Member& member : channel.getMembers() )
 	{
+		const Client* memberClient = allClients.find(member.client);
+		if (!memberClient)
+			continue;
+
 		// Space separate the NAMES
 		if (!namesList.empty())
 			namesList += " ";
-
-		auto memberIt = allClients.find(memberFd);
-		if (memberIt != allClients.end())
-		{
-			Client& channelMember = const_cast<Client&>(memberIt->second);
-
-			Response::sendResponseCommand("JOIN", client, channelMember, {{"channel", channelName}});
-			if (channel.isOperator(channelMember.getFd()))
-				namesList += "@" + channelMember.getNickname();
-			else
-				namesList += channelMember.getNickname();
-		}
+		if (member.isOperator())
+			namesList += "@";
+		namesList += memberClient->getNickname();
 	}
 
 	// Send list of channel members to the client
-	Response::sendResponseCode(Response::RPL_NAMREPLY, client, {{"symbol", ""}, {"channel", channelName}, {"names", namesList}});
-	Response::sendResponseCode(Response::RPL_ENDOFNAMES, client, {{"channel", channelName}});
+	Response::sendResponseCode(Response::RPL_NAMREPLY, client, {{Field::SYMBOL, ""}, {Field::CHANNEL, channelName}, {Field::NAMES, namesList}});
+	Response::sendResponseCode(Response::RPL_ENDOFNAMES, client, {{Field::CHANNEL, channelName}});
 	if (!channel.getTopic().empty()) //if topic is set, show the topic to who joined
-		Response::sendResponseCode(Response::RPL_TOPIC, client, {{"channel", channelName}, {"topic", channel.getTopic()}});
+		Response::sendResponseCode(Response::RPL_TOPIC, client, {{Field::CHANNEL, channelName}, {Field::TOPIC, channel.getTopic()}});
 }
 
-void	CommandHandler::broadcastPrivmsg( Client& client, Channel& channel, const std::string& message )
+void	CommandHandler::broadcastPrivmsg( Client& client, Channel& channel, std::string_view message )
 {
-	const std::string	channelName	= channel.getName();
-	const auto&			allClients	= _server.getClients();
-
 	if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
-		irc::log_event("CHANNEL", irc::LOG_DEBUG, "broadcast: " + channelName);
-
-	for ( const auto memberFd : channel.getMembers() )
-	{
-		if (memberFd == client.getFd()) continue;
+		irc::log_event("CHANNEL", irc::LOG_DEBUG, irc::concat("broadcast: ", channel.getName()));
 
-		auto memberIt = allClients.find(memberFd);
-		if (memberIt != allClients.end())
-		{
-			Client& channelMember = const_cast<Client&>(memberIt->second);
-			Response::sendResponseCommand("PRIVMSG", client, channelMember, {{"target", channelName}, {"message", message}});
-		}
-	}
+	broadcastLine(channel, Response::renderCommand(CommandType::PRIVMSG, client, {{Field::TARGET, channel.getName()}, {Field::MESSAGE, message}}), &client, true);
 }
 
-void	CommandHandler::broadcastNotice( Client& client, Channel& channel, const std::string& message )
+void	CommandHandler::broadcastNotice( Client& client, Channel& channel, std::string_view message )
 {
-	const auto& allClients = _server.getClients();
-
-	for ( auto fd : channel.getMembers() )
-	{
-		if ( fd == client.getFd() ) continue;
-
-		auto memberIt = allClients.find(fd);
-		if (memberIt != allClients.end())
-		{
-			Client& channelMember = const_cast<Client&>(memberIt->second);
-			Response::sendResponseCommand("NOTICE", client, channelMember, {{ "message", message }});
-		}
-	}
+	broadcastLine(channel, Response::renderCommand(CommandType::NOTICE, client, {{Field::TARGET, channel.getName()}, {Field::MESSAGE, message}}), &client, true);
 }
 
 /**
@@ -91,119 +94,71 @@ void	CommandHandler::broadcastNotice( Client& client, Channel& channel, const st
  * @param channel Where the client is departing from.
  * @param message Reason for parting. Empty reason is defaulted to client nickname.
  */
-void	CommandHandler::broadcastPart( Client& client, Channel& channel, const std::string& message )
+void	CommandHandler::broadcastPart( Client& client, Channel& channel, std::string_view message )
 {
-	const std::string	channelName	= channel.getName();
-	const auto&			allClients	= _server.getClients();
-
-	for ( const auto memberFd : channel.getMembers() )
-	{
-		auto memberIt = allClients.find(memberFd);
-		if (memberIt != allClients.end())
-		{
-			Client& channelMember = const_cast<Client&>(memberIt->second);
-			Response::sendResponseCommand("PART", client, channelMember, {{"channel", channelName}, { "reason", message }});
-		}
-	}
+	broadcastLine(channel, Response::renderCommand(CommandType::PART, client, {{Field::CHANNEL, channel.getName()}, {Field::REASON, message}}), nullptr, false);
 }
 
-void	CommandHandler::broadcastKick( Client& client, Client& target, Channel& channel, const std::string& message )
+void	CommandHandler::broadcastKick( Client& client, Client& target, Channel& channel, std::string_view message )
 {
-	const std::string	channelName	= channel.getName();
-	const auto&			allClients	= _server.getClients();
-
-	for ( const auto memberFd : channel.getMembers() )
-	{
-		auto memberIt = allClients.find(memberFd);
-		if (memberIt != allClients.end())
-		{
-			Client& channelMember = const_cast<Client&>(memberIt->second);
-			Response::sendResponseCommand("KICK", client, channelMember, {{"channel", channelName}, {"target", target.getNickname()}, { "reason", message}});
-		}
-	}
+	broadcastLine(channel, Response::renderCommand(CommandType::KICK, client, {{Field::CHANNEL, channel.getName()}, {Field::TARGET, target.getNickname()}, {Field::REASON, message}}), nullptr, false);
 }
 
 /**
- * @brief Broadcasts QUIT message to all channels which the client was apart of.
- * By the nature of the loop, removes the client from the channel clients list.
+ * @brief Broadcasts QUIT message to all channels which the client was apart of, every member is told once.
+ * By the nature of the loop, removes the client from every channel and empties its channel list.
+ * Channels left empty are removed.
  * If the client was the only person on the channel, then the channel gets removed.
  *
  * @param client Who is quitting.
  * @param message The optional reason for quitting.
  */
-void	CommandHandler::broadcastQuit( Client& client, const std::string& message )
+void	CommandHandler::broadcastQuit( Client& client, std::string_view message )
 {
-	using setIter			= std::unordered_set<std::string>::iterator;
-	const auto& allClients	= _server.getClients();
+	const MessageBlock	line		= Response::renderCommand(CommandType::QUIT, client, {{Field::REASON, message}});
+	ClientTable&		allClients	= _server.getClients();
+	std::pmr::vector<ClientHandle>	recipients(irc::scratch());
 
-	setIter it	= client.getChannels().begin();
-	setIter ite	= client.getChannels().end();
-	for (; it != ite ;)
+	while (!client.getChannels().empty())
 	{
-		Channel* channel = _server.findChannel(*it);
-		if (!channel) { ++it; continue; }
-		// For every member in this channel
-		for (int memberFd : channel->getMembers())
-		{
-			if (memberFd == client.getFd()) continue;
-
-			auto memberIt = allClients.find(memberFd);
-			if (memberIt != allClients.end())
-			{
-				Client& channelMember = const_cast<Client&>(memberIt->second);
-				Response::sendResponseCommand("QUIT", client, channelMember, {{ "reason", message }});
-			}
-		}
+		const ChannelId	channelId	= client.getChannels().back();
+		Channel*		channel		= _server.findChannel(channelId);
 
-		channel->removeMember(client.getFd());
-		channel->removeOperator(client.getFd());
+		client.leaveChannel(channelId);
+		if (!channel) continue;
+
+		channel->removeMember(client.getHandle());
+		for (const Channel::Member& member : channel->getMembers())
+			recipients.push_back(member.client);
 
 		if (channel->isEmpty())
 		{
-			irc::log_event("CHANNEL", irc::LOG_INFO, "removed: " + channel->getName());
+			irc::log_event("CHANNEL", irc::LOG_INFO, irc::concat("removed: ", channel->getName()));
 			_server.removeChannel(channel->getName());
-			it = client.getChannels().erase(it);
-			continue ;
 		}
-		else { ++it; }
 	}
 
-	Response::sendResponseCommand("QUIT", client, client, {{ "reason", message }});
+	// Members sharing several channels with the client are told once
+	std::sort(recipients.begin(), recipients.end());
+	recipients.erase(std::unique(recipients.begin(), recipients.end()), recipients.end());
+	for (const ClientHandle& recipient : recipients)
+	{
+		if (Client* member = allClients.find(recipient))
+			Response::sendMessage(*member, line);
+	}
+
+	Response::sendMessage(client, line);
 }
 
 /**
  * @brief Broadcasts a channel mode change to all users apart of that channel.
  */
-void	CommandHandler::broadcastMode( Client& client, Channel& channel, const std::string& modeStr)
+void	CommandHandler::broadcastMode( Client& client, Channel& channel, std::string_view modeStr )
 {
-	const std::string	channelName	= channel.getName();
-	const auto& 		allClients	= _server.getClients();
-	std::string			target;
-
-	// Send to all members
-	for ( const auto memberFd : channel.getMembers() )
-	{
-		auto memberIt = allClients.find(memberFd);
-		if (memberIt != allClients.end())
-		{
-			Client& channelMember = const_cast<Client&>(memberIt->second);
-			Response::sendResponseCommand("MODE", client, channelMember, {{"channel", channelName}, {"flags", modeStr}, {"target", target}});
-		}
-	}
+	broadcastLine(channel, Response::renderCommand(CommandType::MODE, client, {{Field::CHANNEL, channel.getName()}, {Field::FLAGS, modeStr}, {Field::TARGET, ""}}), nullptr, false);
 }
 
-void	CommandHandler::broadcastTopic( Client& client, Channel& channel, const std::string& newTopic )
+void	CommandHandler::broadcastTopic( Client& client, Channel& channel, std::string_view newTopic )
 {
-	const std::string	channelName	= channel.getName();
-	const auto& 		allClients	= _server.getClients();
-
-	for ( const auto memberFd : channel.getMembers() )
-	{
-		auto memberIt = allClients.find(memberFd);
-		if (memberIt != allClients.end())
-		{
-			Client& channelMember = const_cast<Client&>(memberIt->second);
-			Response::sendResponseCommand("TOPIC", client, channelMember, {{"channel", channelName}, {"topic", newTopic}});
-		}
-	}
+	broadcastLine(channel, Response::renderCommand(CommandType::TOPIC, client, {{Field::CHANNEL, channel.getName()}, {Field::TOPIC, newTopic}}), nullptr, false);
 }
@@ -7,87 +7,117 @@
 #include "constants.hpp"
 #include <algorithm>
 
+// Type definitions
+using Field = Response::Field;
 
-CommandHandler::CommandHandler(Server& server) : _server(server)
+
+/**
+ * Dispatch table, one entry per CommandType in the same order.
+ * Flood cost follows the usual penalty scheme: one for cheap commands,
+ * more for commands which fan out to many recipients or change shared state.
+ * It is charged against the client's flood budget for the loop tick, irc::CLIENT_FLOOD_BUDGET.
+ * Commands changing nicknames, channels or registration run with the state lock held exclusively.
+ */
+const CommandHandler::CommandSpec	CommandHandler::_commands[] =
 {
+	//	name		handler							registered	minParams	logged						exclusive	floodCost
+	{	"",			nullptr,						false,		0,			true,						false,		1	}, // UNKNOWN
+
 	// Registration commands
-	_handlers["PASS"]		= [this](Client& c, const Command& cmd) { handlePass(c, cmd); };
-	_handlers["NICK"] 		= [this](Client& c, const Command& cmd) { handleNick(c, cmd); };
-	_handlers["USER"] 		= [this](Client& c, const Command& cmd) { handleUser(c, cmd); };
+	{	"PASS",		&CommandHandler::handlePass,	false,		1,			true,						true,		1	},
+	{	"NICK",		&CommandHandler::handleNick,	false,		0,			true,						true,		2	},
+	{	"USER",		&CommandHandler::handleUser,	false,		4,			true,						true,		1	},
 
 	// Message commands
-	_handlers["PRIVMSG"] 	= [this](Client& c, const Command& cmd) { handlePrivmsg(c, cmd); };
-	_handlers["NOTICE"] 	= [this](Client& c, const Command& cmd) { handleNotice(c, cmd); };
+	{	"PRIVMSG",	&CommandHandler::handlePrivmsg,	true,		2,			true,						false,		2	},
+	{	"NOTICE",	&CommandHandler::handleNotice,	true,		2,			true,						false,		2	},
 
 	// Channel commands
-	_handlers["JOIN"]		= [this](Client& c, const Command& cmd) { handleJoin(c, cmd); };
-	_handlers["PART"]		= [this](Client& c, const Command& cmd) { handlePart(c, cmd); };
-	_handlers["KICK"]		= [this](Client& c, const Command& cmd) { handleKick(c, cmd); };
-	_handlers["INVITE"]		= [this](Client& c, const Command& cmd) { handleInvite(c, cmd); };
-	_handlers["TOPIC"]		= [this](Client& c, const Command& cmd) { handleTopic(c, cmd); };
-	_handlers["MODE"]		= [this](Client& c, const Command& cmd) { handleMode(c, cmd); };
+	{	"JOIN",		&CommandHandler::handleJoin,	true,		1,			true,						true,		2	},
+	{	"PART",		&CommandHandler::handlePart,	true,		1,			true,						true,		2	},
+	{	"KICK",		&CommandHandler::handleKick,	true,		2,			true,						true,		2	},
+	{	"INVITE",	&CommandHandler::handleInvite,	true,		2,			true,						true,		2	},
+	{	"TOPIC",	&CommandHandler::handleTopic,	true,		1,			true,						true,		2	},
+	{	"MODE",		&CommandHandler::handleMode,	false,		1,			true,						true,		2	},
 
 	// Rest of the commands
-	_handlers["QUIT"]		= [this](Client& c, const Command& cmd) { handleQuit(c, cmd); };
-	_handlers["PING"]		= [this](Client& c, const Command& cmd) { handlePing(c, cmd); };
-	_handlers["PONG"]		= [this](Client& c, const Command& cmd) { handlePong(c, cmd); };
+	{	"QUIT",		&CommandHandler::handleQuit,	false,		0,			true,						true,		1	},
+	{	"PING",		&CommandHandler::handlePing,	false,		1,			irc::ENABLE_PING_LOGGING,	false,		1	},
+	{	"PONG",		&CommandHandler::handlePong,	false,		0,			irc::ENABLE_PING_LOGGING,	false,		1	},
 
 	// Additional commands
-	_handlers["SUMMON"]		= [this](Client& c, const Command& cmd) { handleSummon(c, cmd); };
-	_handlers["USERS"]		= [this](Client& c, const Command& cmd) { handleUsers(c, cmd); };
-	_handlers["WHOIS"]		= [this](Client& c, const Command& cmd) { handleWhois(c, cmd); };
-	_handlers["WHO"]		= [this](Client& c, const Command& cmd) { handleWhois(c, cmd); };
+	{	"SUMMON",	&CommandHandler::handleSummon,	false,		0,			true,						false,		1	},
+	{	"USERS",	&CommandHandler::handleUsers,	false,		0,			true,						false,		1	},
+	{	"WHOIS",	&CommandHandler::handleWhois,	false,		0,			true,						false,		1	},
+	{	"WHO",		&CommandHandler::handleWho,		false,		0,			true,						false,		1	},
+};
+
+CommandHandler::CommandHandler(Server& server) : _server(server)
+{
+	static_assert( std::size(_commands) == static_cast<size_t>(CommandType::COUNT), "Every command needs a dispatch entry" );
+}
+
+// Whether the command runs with the state lock held exclusively, see the dispatch table
+bool	CommandHandler::isExclusive(CommandType type)
+{
+	return _commands[static_cast<size_t>(type)].exclusive;
+}
+
+// What the command is charged against the client's flood budget, unknown commands included
+unsigned	CommandHandler::floodCost(CommandType type)
+{
+	return _commands[static_cast<size_t>(type)].floodCost;
 }
 
 /**
  * Command handler function, for fast execution of any command.
- * This function iterates through _handlers(map of command keys and funcs),
- * finds a match, and executes the command internally.
+ * The parser already recognized the command, so this is a single table lookup.
+ * Registration and parameter count are checked from the table before the handler runs.
  * Server response to client will also be sent internally.
- * If no match is found, server immediately responds with unknown command error.
+ * If the command is unknown, server immediately responds with unknown command error.
  */
 void	CommandHandler::handleCommand(Client& client, const Command& cmd)
 {
-	auto it = _handlers.find(cmd.command);
-	if (it != _handlers.end())
-	{
-		if constexpr ( irc::ENABLE_COMMAND_LOGGING )
-		{
-			if ( (cmd.command != "PING" && cmd.command != "PONG") ||
-			(irc::ENABLE_PING_LOGGING && (cmd.command == "PING" || cmd.command == "PONG")) )
-			{
-				irc::log_event("COMMAND", irc::LOG_INFO, cmd.command + " from " + (client.getNickname().empty() ? "*" : client.getNickname()) + "@" + client.getIpAddress());
-			}
-		}
-		client.updateLastActivity();
-		it->second(client, cmd);
-	}
-	else
+	if (cmd.type == CommandType::UNKNOWN)
 	{
+		irc::ScratchString	command(cmd.command, irc::scratch());
+		std::transform(command.begin(), command.end(), command.begin(), ::toupper);
+
 		if constexpr ( irc::ENABLE_COMMAND_LOGGING )
-			irc::log_event("COMMAND", irc::LOG_FAIL, "unknown " + cmd.command + " from " + (client.getNickname().empty() ? "*" : client.getNickname()) + "@" + client.getIpAddress());
-		Response::sendResponseCode(Response::ERR_UNKNOWNCOMMAND, client, {{"command", cmd.command}});
+			irc::log_event("COMMAND", irc::LOG_FAIL, irc::concat("unknown ", command, " from ", logName(client), "@", client.getIpAddress()));
+		Response::sendResponseCode(Response::ERR_UNKNOWNCOMMAND, client, {{Field::COMMAND, command}});
+		return ;
 	}
-}
 
+	const CommandSpec&	spec = _commands[static_cast<size_t>(cmd.type)];
 
-/* MESSAGE COMMANDS */
+	if constexpr ( irc::ENABLE_COMMAND_LOGGING )
+	{
+		if (spec.logged)
+			irc::log_event("COMMAND", irc::LOG_INFO, irc::concat(spec.name, " from ", logName(client), "@", client.getIpAddress()));
+	}
+	client.updateLastActivity();
 
-void	CommandHandler::handlePrivmsg(Client& client, const Command& cmd)
-{
-	if (!client.isAuthenticated())
+	if (spec.registered && !client.isAuthenticated())
 	{
 		Response::sendResponseCode(Response::ERR_NOTREGISTERED, client, {});
 		return ;
 	}
-	else if (cmd.params.size() < 2)
+	if (cmd.params.size() < spec.minParams)
 	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "PRIVMSG"}});
+		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{Field::COMMAND, spec.name}});
 		return ;
 	}
+	(this->*spec.handler)(client, cmd);
+}
+
 
-	std::string	target = cmd.params[0];
-	std::string	message = cmd.params[1];
+/* MESSAGE COMMANDS */
+
+void	CommandHandler::handlePrivmsg(Client& client, const Command& cmd)
+{
+	std::string_view	target	= cmd.params[0];
+	std::string_view	message	= cmd.params[1];
 
 	if ( message.empty() )
 	{
@@ -97,11 +127,11 @@ void	CommandHandler::handlePrivmsg(Client& client, const Command& cmd)
 
 	if (target[0] == '#' || target[0] == '&')
 	{
-		target = toLowerCase(target); //Channels are stored in lowercase.
-		Channel *channel = _server.findChannel(target);
+		irc::ScratchString	channelName = toLowerCase(target); //Channels are stored in lowercase.
+		Channel *channel = _server.findChannel(channelName);
 		if (!channel)
 		{
-			Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{"channel", target}});
+			Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{Field::CHANNEL, channelName}});
 			return ;
 		}
 		broadcastPrivmsg(client, *channel, message);
@@ -111,10 +141,10 @@ void	CommandHandler::handlePrivmsg(Client& client, const Command& cmd)
 		Client	*recipient = _server.findUser(target);
 		if (!recipient)
 		{
-			Response::sendResponseCode(Response::ERR_NOSUCHNICK, client, {{"nick", target}});
+			Response::sendResponseCode(Response::ERR_NOSUCHNICK, client, {{Field::NICK, target}});
 			return ;
 		}
-		Response::sendResponseCommand("PRIVMSG", client, *recipient, {{"target", recipient->getNickname()}, {"message", message}});
+		Response::sendResponseCommand(CommandType::PRIVMSG, client, *recipient, {{Field::TARGET, recipient->getNickname()}, {Field::MESSAGE, message}});
 	}
 }
 
@@ -126,27 +156,15 @@ void	CommandHandler::handlePrivmsg(Client& client, const Command& cmd)
  */
 void	CommandHandler::handleNotice( Client& client, const Command& cmd)
 {
-	if (!client.isAuthenticated())
-	{
-		Response::sendResponseCode(Response::ERR_NOTREGISTERED, client, {});
-		return ;
-	}
-	if ( cmd.params.size() < 2)
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "NOTICE"}});
-		return ;
-	}
-
-	std::string	target	= cmd.params[0];
-	std::string	message	= cmd.params[1];
+	std::string_view	target	= cmd.params[0];
+	std::string_view	message	= cmd.params[1];
 
 	if ( message.empty() || target.empty() )
 		return ;
 
 	if (target[0] == '#')
 	{
-		target = toLowerCase(target);
-		Channel	*channel = _server.findChannel(target);
+		Channel	*channel = _server.findChannel(toLowerCase(target));
 		if (!channel)
 			return ;
 
@@ -158,7 +176,7 @@ void	CommandHandler::handleNotice( Client& client, const Command& cmd)
 		if (!recipient)
 			return ;
 
-		Response::sendResponseCommand("NOTICE", client, *recipient, {{ "message", message }});
+		Response::sendResponseCommand(CommandType::NOTICE, client, *recipient, {{ Field::TARGET, recipient->getNickname() }, { Field::MESSAGE, message }});
 	}
 }
 
@@ -166,24 +184,19 @@ void	CommandHandler::handleNotice( Client& client, const Command& cmd)
 
 void	CommandHandler::handleJoin(Client& client, const Command& cmd)
 {
-	if (!client.isAuthenticated())
+	if (cmd.params[0].empty())
 	{
-		Response::sendResponseCode(Response::ERR_NOTREGISTERED, client, {});
-		return ;
-	}
-	if (cmd.params.empty() || cmd.params[0].empty()) // Also check that the vector isn't empty
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "JOIN"}});
+		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{Field::COMMAND, "JOIN"}});
 		return ;
 	}
 	if (client.getChannels().size() == irc::MAX_CHANNELS)
 	{
-		Response::sendResponseCode(Response::ERR_TOOMANYCHANNELS, client, {{"channel", cmd.params[0]}});
+		Response::sendResponseCode(Response::ERR_TOOMANYCHANNELS, client, {{Field::CHANNEL, cmd.params[0]}});
 		return ;
 	}
 
-	std::string	target	= toLowerCase(cmd.params[0]); //Channel names are stored in lowercase..
-	std::string	key		= (cmd.params.size() > 1) ? cmd.params[1] : "";
+	irc::ScratchString	target	= toLowerCase(cmd.params[0]); //Channel names are stored in lowercase..
+	std::string_view	key		= (cmd.params.size() > 1) ? cmd.params[1] : "";
 
 	Channel* channel	= _server.findChannel(target);
 
@@ -194,58 +207,58 @@ void	CommandHandler::handleJoin(Client& client, const Command& cmd)
 
 		if (!channel)
 		{
-			irc::log_event("CHANNEL", irc::LOG_FAIL, "failed to create: " + target);
+			irc::log_event("CHANNEL", irc::LOG_FAIL, irc::concat("failed to create: ", target));
 			return ;
 		}
-		irc::log_event("CHANNEL", irc::LOG_INFO, "created: " + target);
+		irc::log_event("CHANNEL", irc::LOG_INFO, irc::concat("created: ", target));
 
 		if (!key.empty())
 			channel->setKey(key);
 
-		channel->addMember(client.getFd());
-		client.joinChannel(channel->getName());
-		channel->addOperator(client.getFd());
+		channel->addMember(client.getHandle());
+		client.joinChannel(channel->getId());
+		channel->addOperator(client.getHandle());
 
-		irc::log_event("CHANNEL", irc::LOG_INFO, client.getNickname() + "@" + client.getIpAddress() + " joined " + target);
+		irc::log_event("CHANNEL", irc::LOG_INFO, irc::concat(client.getNickname(), "@", client.getIpAddress(), " joined ", target));
 		broadcastJoin(client, *channel);
 		return ;
 	}
 
 	if (channel->isFull())
 	{
-		Response::sendResponseCode(Response::ERR_CHANNELISFULL, client, {{"channel", target}});
+		Response::sendResponseCode(Response::ERR_CHANNELISFULL, client, {{Field::CHANNEL, target}});
 		return ;
 	}
 
 	if (channel->isInviteOnly())
 	{
-		if (channel->isInvited(client.getFd()))
+		if (channel->isInvited(client.getHandle()))
 		{
-			if (channel->addMember(client.getFd()) == true)
+			if (channel->addMember(client.getHandle()) == true)
 			{
-				client.joinChannel(channel->getName());
-				irc::log_event("CHANNEL", irc::LOG_INFO, client.getNickname() + "@" + client.getIpAddress() + " joined " + target);
+				client.joinChannel(channel->getId());
+				irc::log_event("CHANNEL", irc::LOG_INFO, irc::concat(client.getNickname(), "@", client.getIpAddress(), " joined ", target));
 				broadcastJoin(client, *channel);
 			}
 		}
 		else
-			Response::sendResponseCode(Response::ERR_INVITEONLYCHAN, client, {{"channel", target}});
+			Response::sendResponseCode(Response::ERR_INVITEONLYCHAN, client, {{Field::CHANNEL, target}});
 		return ;
 	}
 
 	if ( !channel->getKey().empty() )
 	{
-		if ( (key.empty() || (channel->getKey() != key)) && !channel->isInvited(client.getFd()) )
+		if ( (key.empty() || (channel->getKey() != key)) && !channel->isInvited(client.getHandle()) )
 		{
-			Response::sendResponseCode(Response::ERR_BADCHANNELKEY, client, {{"channel", target}});
+			Response::sendResponseCode(Response::ERR_BADCHANNELKEY, client, {{Field::CHANNEL, target}});
 			return ;
 		}
 		else
 		{
-			if (channel->addMember(client.getFd()) == true)
+			if (channel->addMember(client.getHandle()) == true)
 			{
-				client.joinChannel(channel->getName());
-				irc::log_event("CHANNEL", irc::LOG_INFO, client.getNickname() + "@" + client.getIpAddress() + " joined " + target);
+				client.joinChannel(channel->getId());
+				irc::log_event("CHANNEL", irc::LOG_INFO, irc::concat(client.getNickname(), "@", client.getIpAddress(), " joined ", target));
 				broadcastJoin(client, *channel);
 			}
 			return ;
@@ -253,10 +266,10 @@ void	CommandHandler::handleJoin(Client& client, const Command& cmd)
 	}
 	else
 	{
-		if (channel->addMember(client.getFd()) == true)
+		if (channel->addMember(client.getHandle()) == true)
 		{
-			client.joinChannel(channel->getName());
-			irc::log_event("CHANNEL", irc::LOG_INFO, client.getNickname() + "@" + client.getIpAddress() + " joined " + target);
+			client.joinChannel(channel->getId());
+			irc::log_event("CHANNEL", irc::LOG_INFO, irc::concat(client.getNickname(), "@", client.getIpAddress(), " joined ", target));
 			broadcastJoin(client, *channel);
 		}
 		return ;
@@ -265,43 +278,32 @@ void	CommandHandler::handleJoin(Client& client, const Command& cmd)
 
 void	CommandHandler::handlePart(Client& client, const Command& cmd)
 {
-	if (!client.isAuthenticated())
-	{
-		Response::sendResponseCode(Response::ERR_NOTREGISTERED, client, {});
-		return ;
-	}
-	if (cmd.params.size() < 1)
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "PART"}});
-		return ;
-	}
-
-	std::string	channelName		= toLowerCase(cmd.params[0]); //Channel names are stored in lowercase
-	std::string	optionalMessage	= (cmd.params.size() > 1) ? cmd.params[1] : "";
+	irc::ScratchString	channelName		= toLowerCase(cmd.params[0]); //Channel names are stored in lowercase
+	std::string_view	optionalMessage	= (cmd.params.size() > 1) ? cmd.params[1] : "";
 
 	Channel* channel = _server.findChannel(channelName);
 
 	if (!channel)
 	{
-		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{"channel", channelName}});
+		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{Field::CHANNEL, channelName}});
 		return ;
 	}
-	if (!channel->isMember(client.getFd()))
+	if (!channel->isMember(client.getHandle()))
 	{
-		Response::sendResponseCode(Response::ERR_NOTONCHANNEL, client, {{"channel", channel->getName()}});
+		Response::sendResponseCode(Response::ERR_NOTONCHANNEL, client, {{Field::CHANNEL, channel->getName()}});
 		return ;
 	}
 
 	broadcastPart(client, *channel, optionalMessage);
 
-	irc::log_event("CHANNEL", irc::LOG_INFO, client.getNickname() + "@" + client.getIpAddress() + " left " + channelName);
-	channel->removeMember(client.getFd());
-	client.leaveChannel(channel->getName());
+	irc::log_event("CHANNEL", irc::LOG_INFO, irc::concat(client.getNickname(), "@", client.getIpAddress(), " left ", channelName));
+	channel->removeMember(client.getHandle());
+	client.leaveChannel(channel->getId());
 
 	// Remove the channel if no members exist after leaving.
 	if (channel->isEmpty())
 	{
-		irc::log_event("CHANNEL", irc::LOG_INFO, "removed: " + channelName);
+		irc::log_event("CHANNEL", irc::LOG_INFO, irc::concat("removed: ", channelName));
 		_server.removeChannel(channel->getName());
 		return ;
 	}
@@ -309,23 +311,12 @@ void	CommandHandler::handlePart(Client& client, const Command& cmd)
 
 void	CommandHandler::handleKick(Client& client, const Command& cmd)
 {
-	if (!client.isAuthenticated())
-	{
-		Response::sendResponseCode(Response::ERR_NOTREGISTERED, client, {});
-		return ;
-	}
-	if (cmd.params.size() < 2)
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "KICK"}});
-		return ;
-	}
-
 	Channel*	channel = _server.findChannel(cmd.params[0]);
 	Client*		target = _server.findUser(cmd.params[1]);
 
 	if (!channel)
 	{
-		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{"channel", cmd.params[0]}});
+		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{Field::CHANNEL, cmd.params[0]}});
 		return ;
 	}
 	if (!target)
@@ -333,24 +324,24 @@ void	CommandHandler::handleKick(Client& client, const Command& cmd)
 		Response::sendResponseCode(Response::ERR_NOSUCHNICK, client, {});
 		return ;
 	}
-	if (!channel->isOperator(client.getFd()))
+	if (!channel->isOperator(client.getHandle()))
 	{
-		Response::sendResponseCode(Response::ERR_CHANOPRIVSNEEDED, client, {{"channel", channel->getName()}});
+		Response::sendResponseCode(Response::ERR_CHANOPRIVSNEEDED, client, {{Field::CHANNEL, channel->getName()}});
 		return ;
 	}
-	if (!channel->isMember(target->getFd()))
+	if (!channel->isMember(target->getHandle()))
 	{
-		Response::sendResponseCode(Response::ERR_USERNOTINCHANNEL, client, {{"target", target->getNickname()}, \
-																			{"channel", channel->getName()}});
+		Response::sendResponseCode(Response::ERR_USERNOTINCHANNEL, client, {{Field::TARGET, target->getNickname()}, \
+																			{Field::CHANNEL, channel->getName()}});
 		return ;
 	}
-	if (!channel->isMember(client.getFd()))
+	if (!channel->isMember(client.getHandle()))
 	{
-		Response::sendResponseCode(Response::ERR_NOTONCHANNEL, client, {{"channel", channel->getName()}});
+		Response::sendResponseCode(Response::ERR_NOTONCHANNEL, client, {{Field::CHANNEL, channel->getName()}});
 		return ;
 	}
 
-	std::string	message;
+	std::string_view	message;
 	if (cmd.params.size() > 2)
 	{
 		size_t pos = cmd.params[2].find_first_of(':');
@@ -365,87 +356,66 @@ void	CommandHandler::handleKick(Client& client, const Command& cmd)
 	}
 
 	broadcastKick(client, *target, *channel, message);
-	channel->removeMember(target->getFd());
-	target->leaveChannel(channel->getName());
+	channel->removeMember(target->getHandle());
+	target->leaveChannel(channel->getId());
 }
 
 void	CommandHandler::handleInvite(Client& client, const Command& cmd)
 {
-	if (!client.isAuthenticated())
-	{
-		Response::sendResponseCode(Response::ERR_NOTREGISTERED, client, {});
-		return ;
-	}
-	if ( cmd.params.size() < 2 || cmd.params.empty() )
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "INVITE"}});
-		return ;
-	}
-
-	std::string	channelName = toLowerCase(cmd.params[1]);
-	std::string targetName = cmd.params[0];
+	irc::ScratchString	channelName	= toLowerCase(cmd.params[1]);
+	std::string_view	targetName	= cmd.params[0];
 
 	Client* target = _server.findUser(targetName);
 	Channel* channel = _server.findChannel(channelName);
 
 	if (!target)
 	{
-		Response::sendResponseCode(Response::ERR_NOSUCHNICK, client, {{"target", targetName}});
+		Response::sendResponseCode(Response::ERR_NOSUCHNICK, client, {{Field::TARGET, targetName}});
 		return ;
 	}
 	if (!channel)
 	{
-		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{"channel", channelName}});
+		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{Field::CHANNEL, channelName}});
 		return ;
 	}
-	if (channel->isMember(target->getFd()))
+	if (channel->isMember(target->getHandle()))
 	{
-		Response::sendResponseCode(Response::ERR_USERONCHANNEL, client, {{"target", target->getNickname()}});
+		Response::sendResponseCode(Response::ERR_USERONCHANNEL, client, {{Field::TARGET, target->getNickname()}});
 		return ;
 	}
-	if (channel->isInviteOnly() && !channel->isOperator(client.getFd()))
+	if (channel->isInviteOnly() && !channel->isOperator(client.getHandle()))
 	{
-		Response::sendResponseCode(Response::ERR_CHANOPRIVSNEEDED, client, {{"channel", channel->getName()}});
+		Response::sendResponseCode(Response::ERR_CHANOPRIVSNEEDED, client, {{Field::CHANNEL, channel->getName()}});
 		return ;
 	}
-	channel->invite(target->getFd());
-	Response::sendResponseCommand("INVITE", client, *target, {{"target", target->getNickname() }, {"channel", channel->getName()}});
-	Response::sendResponseCode(Response::RPL_INVITING, client, {{"target", target->getNickname()}, {"channel", channel->getName()}});
+	channel->invite(target->getHandle());
+	target->addInvite(channel->getId());
+	Response::sendResponseCommand(CommandType::INVITE, client, *target, {{Field::TARGET, target->getNickname() }, {Field::CHANNEL, channel->getName()}});
+	Response::sendResponseCode(Response::RPL_INVITING, client, {{Field::TARGET, target->getNickname()}, {Field::CHANNEL, channel->getName()}});
 }
 
 void	CommandHandler::handleTopic(Client& client, const Command& cmd)
 {
-	if (!client.isAuthenticated())
-	{
-		Response::sendResponseCode(Response::ERR_NOTREGISTERED, client, {});
-		return ;
-	}
-	if (cmd.params.size() < 1)
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {});
-		return ;
-	}
-
-	std::string	channelName = toLowerCase(cmd.params[0]);
-	std::string	newTopic = (cmd.params.size() >= 2) ? cmd.params[1] : "";
+	irc::ScratchString	channelName	= toLowerCase(cmd.params[0]);
+	std::string_view	newTopic	= (cmd.params.size() >= 2) ? cmd.params[1] : "";
 
 	Channel* channel = _server.findChannel(channelName);
 
 	if (!channel)
 	{
-		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{"channel", channelName}});
+		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{Field::CHANNEL, channelName}});
 		return ;
 	}
-	if (!channel->isMember(client.getFd()))
+	if (!channel->isMember(client.getHandle()))
 	{
-		Response::sendResponseCode(Response::ERR_USERNOTINCHANNEL, client, {{"channel", channelName}});
+		Response::sendResponseCode(Response::ERR_USERNOTINCHANNEL, client, {{Field::CHANNEL, channelName}});
 		return ;
 	}
 	if (!newTopic.empty())
 	{
-		if (channel->isTopicLocked() && !channel->isOperator(client.getFd()))
+		if (channel->isTopicLocked() && !channel->isOperator(client.getHandle()))
 		{
-			Response::sendResponseCode(Response::ERR_CHANOPRIVSNEEDED, client, {{"channel", channel->getName()}});
+			Response::sendResponseCode(Response::ERR_CHANOPRIVSNEEDED, client, {{Field::CHANNEL, channel->getName()}});
 			return ;
 		}
 		channel->setTopic(newTopic);
@@ -454,9 +424,9 @@ void	CommandHandler::handleTopic(Client& client, const Command& cmd)
 	else
 	{
 		if (channel->getTopic().empty())
-			Response::sendResponseCode(Response::RPL_NOTOPIC, client, {{"channel", channel->getName()}});
+			Response::sendResponseCode(Response::RPL_NOTOPIC, client, {{Field::CHANNEL, channel->getName()}});
 		else
-			Response::sendResponseCode(Response::RPL_TOPIC, client, {{"channel", channel->getName()}, {"topic", channel->getTopic()}});
+			Response::sendResponseCode(Response::RPL_TOPIC, client, {{Field::CHANNEL, channel->getName()}, {Field::TOPIC, channel->getTopic()}});
 	}
 }
 
@@ -476,33 +446,27 @@ void	CommandHandler::handlePass(Client& client, const Command& cmd)
 		return ;
 	}
 
-	if (cmd.params.empty())
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "PASS"}});
-		return ;
-	}
-
-	const std::string& providedPassword = cmd.params[0];
+	std::string_view providedPassword = cmd.params[0];
 	if (providedPassword != _server.getPassword())
 	{
 		Response::sendResponseCode(Response::ERR_PASSWDMISMATCH, client, {});
 		if ( !_server.getPassword().empty() )
 		{
 			client.incrementPassAttempts();
-			irc::log_event("AUTH", irc::LOG_FAIL, "incorrect password from " + client.getIpAddress());
+			irc::log_event("AUTH", irc::LOG_FAIL, irc::concat("incorrect password from ", client.getIpAddress()));
 
 			if (client.getPasswordAttempts() >= irc::MAX_PASSWORD_ATTEMPTS)
 			{
 				Response::sendServerError( client, client.getIpAddress(), "incorrect password");
 				client.setActive(false);
-				_server.setDisconnectEvent(true);
+				Server::setDisconnectEvent(client);
 			}
 			return ;
 		}
 	}
 
 	client.setPassValidated(true);
-	irc::log_event("AUTH", irc::LOG_INFO, "valid password from "+ client.getIpAddress());
+	irc::log_event("AUTH", irc::LOG_INFO, irc::concat("valid password from ", client.getIpAddress()));
 
 	CommandHandler::confirmAuth(client);
 }
@@ -515,7 +479,7 @@ void CommandHandler::handleNick(Client& client, const Command& cmd)
 		return ;
 	}
 
-	std::string newNick = cmd.params[0];
+	std::string_view	newNick = cmd.params[0];
 
 	if ( !CommandHandler::isValidNick(newNick) )
 	{
@@ -523,30 +487,28 @@ void CommandHandler::handleNick(Client& client, const Command& cmd)
 		return ;
 	}
 
-	for (const auto& [fd, clientObject] : _server.getClients())
+	const Client* holder = _server.findUser(newNick);
+	if (holder && holder != &client)
 	{
-		if (clientObject.getNickname() == newNick && static_cast<int>(fd) != client.getFd() )
-		{
-			if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
-				irc::log_event("AUTH", irc::LOG_FAIL, newNick + " already in use");
-			Response::sendResponseCode(Response::ERR_NICKNAMEINUSE, client, {{"new nick", newNick}});
-			return ;
-		}
+		if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
+			irc::log_event("AUTH", irc::LOG_FAIL, irc::concat(newNick, " already in use"));
+		Response::sendResponseCode(Response::ERR_NICKNAMEINUSE, client, {{Field::NEW_NICK, newNick}});
+		return ;
 	}
 	if (client.getNickname() != newNick)
 	{
 		if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
-			irc::log_event("AUTH", irc::LOG_INFO, newNick + " set by " + client.getIpAddress());
+			irc::log_event("AUTH", irc::LOG_INFO, irc::concat(newNick, " set by ", client.getIpAddress()));
 		if (!client.getNickname().empty())
-			Response::sendResponseCommand("NICK", client, client, {{"new nick", newNick}});
-		client.setNickname(newNick);
+			Response::sendResponseCommand(CommandType::NICK, client, client, {{Field::NEW_NICK, newNick}});
+		_server.renameUser(client, newNick);
 	}
 
 	if (!CommandHandler::confirmAuth(client) && client.getPasswordAttempts() >= irc::MAX_PASSWORD_ATTEMPTS)
 	{
 		Response::sendServerError( client, client.getIpAddress(), "incorrect password");
 		client.setActive(false);
-		_server.setDisconnectEvent(true);
+		Server::setDisconnectEvent(client);
 	}
 }
 
@@ -562,20 +524,14 @@ void CommandHandler::handleUser(Client& client, const Command& cmd)
 		return ;
 	}
 
-	if (cmd.params.size() < 4)
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "USER"}}); // The outer { ... } is for the map initializer. The inner { ... } is for each key-value pair.
-		return ;
-	}
-
-	std::string username	= cmd.params[0];
-	std::string hostname	= cmd.params[1];
-	std::string servername	= cmd.params[2];
-	std::string realname	= cmd.params[3];
+	std::string username(cmd.params[0]);
+	std::string hostname(cmd.params[1]);
+	std::string servername(cmd.params[2]);
+	std::string realname(cmd.params[3]);
 
 	if (username.empty() || hostname.empty() || servername.empty() || realname.empty())
 	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "USER"}});
+		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{Field::COMMAND, "USER"}});
 		return ;
 	}
 
@@ -597,7 +553,7 @@ void CommandHandler::handleUser(Client& client, const Command& cmd)
 	{
 		Response::sendServerError( client, client.getIpAddress(), "incorrect password");
 		client.setActive(false);
-		_server.setDisconnectEvent(true);
+		Server::setDisconnectEvent(client);
 	}
 }
 
@@ -606,12 +562,10 @@ void CommandHandler::handleUser(Client& client, const Command& cmd)
 void CommandHandler::handleQuit(Client& client, const Command& cmd)
 {
 	// Has tto be empty string in case reason is not given.
-	std::string quitMessage = "";
+	std::string_view quitMessage = "";
 	if (!cmd.params.empty())
 	{
 		quitMessage = cmd.params[0];
-		if (!quitMessage.empty() && quitMessage[0] == ':')
-			quitMessage = quitMessage.substr(1);
 	}
 
 	// Broadcast the client disconnection to each member of every channel they were apart of.
@@ -622,19 +576,12 @@ void CommandHandler::handleQuit(Client& client, const Command& cmd)
 
 	// Client is set as inactive and disconnection event gets announced to the server
 	client.setActive(false);
-	Server::setDisconnectEvent(true);
+	Server::setDisconnectEvent(client);
 }
 
 void CommandHandler::handlePing(Client& client, const Command& cmd)
 {
-	if (cmd.params.empty())
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "PING"}});
-		return ;
-	}
-	std::string token = cmd.params[0];
-
-	Response::sendPong( client, token );
+	Response::sendPong( client, cmd.params[0] );
 }
 
 /**
@@ -648,6 +595,7 @@ void CommandHandler::handlePong( Client& client, const Command& cmd)
 		{
 			client.setPingPending(false);
 			client.updateLastActivity();
+			_server.scheduleKeepalive(client); // The pending timer is the ping expiry, a whole timeout away
 		}
 	}
 }
@@ -656,12 +604,7 @@ void CommandHandler::handlePong( Client& client, const Command& cmd)
 
 void CommandHandler::handleMode(Client& client, const Command& cmd)
 {
-	if (cmd.params.empty())
-	{
-		Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "MODE"}});
-		return ;
-	}
-	const std::string& target = cmd.params[0];
+	std::string_view target = cmd.params[0];
 	if (CommandHandler::isChannelName(target))
 	{
 		handleChannelMode(client, cmd, toLowerCase(target));
@@ -7,7 +7,7 @@
 /**
  * @brief Used by handleNick for nickname validation
  */
-bool	CommandHandler::isValidNick( const std::string& nick )
+bool	CommandHandler::isValidNick( std::string_view nick )
 {
 	if (nick.empty() || nick.length() > 9)
 		return false;
@@ -34,18 +34,31 @@ bool	CommandHandler::isValidNick( const std::string& nick )
 	return true;
 }
 
-std::string	CommandHandler::toLowerCase( const std::string& s )
+/**
+ * @brief Lowercased copy of s, allocated from the scratch arena so it only lives until the end of the tick.
+ */
+irc::ScratchString	CommandHandler::toLowerCase( std::string_view s )
 {
-	std::string result = s;
+	irc::ScratchString result(s, irc::scratch());
 	std::transform(result.begin(), result.end(), result.begin(), ::tolower);
 	return result;
 }
 
-bool	CommandHandler::isChannelName( const std::string& name )
+bool	CommandHandler::isChannelName( std::string_view name )
 {
 	return !name.empty() && (name[0] == '#' || name[0] == '&');
 }
 
+/**
+ * @brief Nickname shown in log lines, "*" before one is set.
+ */
+std::string_view	CommandHandler::logName( const Client& client )
+{
+	if (client.getNickname().empty())
+		return "*";
+	return client.getNickname();
+}
+
 /**
  * @brief Authenticates the given client if they have provided with all the required fields.
  * Sends welcome messages to the client if they were authenticated successfully.
@@ -69,7 +82,7 @@ bool	CommandHandler::confirmAuth( Client& client )
 		}
 		client.setAuthenticated(true);
 		Response::sendWelcome(client);
-		irc::log_event("AUTH", irc::LOG_SUCCESS, client.getNickname() + "@" + client.getIpAddress() + " authenticated");
+		irc::log_event("AUTH", irc::LOG_SUCCESS, irc::concat(client.getNickname(), "@", client.getIpAddress(), " authenticated"));
 	}
 	return true;
 }
@@ -89,7 +102,7 @@ bool	CommandHandler::requiresParam( char mode, bool adding )
 	return mode == 'o' || ( mode == 'k' && adding ) || ( mode == 'l' && adding );
 }
 
-std::string	CommandHandler::inlineParam( const std::string& tokens, size_t& index, std::function<bool(char)> condition )
+std::string	CommandHandler::inlineParam( std::string_view tokens, size_t& index, std::function<bool(char)> condition )
 {
 	std::string param;
 	while ( index + 1 < tokens.length() && condition(tokens[index + 1]) )
@@ -7,13 +7,16 @@
 #include "constants.hpp"
 #include "Mode.hpp"
 
+// Type definitions
+using Field = Response::Field;
 
-void CommandHandler::handleChannelMode(Client& client, const Command& cmd, const std::string& channelName)
+
+void CommandHandler::handleChannelMode(Client& client, const Command& cmd, std::string_view channelName)
 {
 	Channel* channel = _server.findChannel(channelName); // A pointer here because a channel might not exist (will return a nullptr in this case). A reference would not work here, as reference must always refer to a valid object
 	if (!channel)
 	{
-		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{"channel", channelName}});
+		Response::sendResponseCode(Response::ERR_NOSUCHCHANNEL, client, {{Field::CHANNEL, channelName}});
 		return ;
 	}
 
@@ -25,9 +28,9 @@ void CommandHandler::handleChannelMode(Client& client, const Command& cmd, const
 	}
 
 	// Checking operator priviliges
-	if (!channel->isOperator(client.getFd()))
+	if (!channel->isOperator(client.getHandle()))
 	{
-		Response::sendResponseCode(Response::ERR_CHANOPRIVSNEEDED, client, {{"channel", channelName}});
+		Response::sendResponseCode(Response::ERR_CHANOPRIVSNEEDED, client, {{Field::CHANNEL, channelName}});
 		return ;
 	}
 
@@ -40,10 +43,10 @@ void CommandHandler::handleChannelMode(Client& client, const Command& cmd, const
 	applyChannelModes(client, *channel, modes);
 }
 
-void CommandHandler::sendChannelModeReply(Client& client, Channel* channel, const std::string& channelName)
+void CommandHandler::sendChannelModeReply(Client& client, Channel* channel, std::string_view channelName)
 {
-	std::string modes = "+";
-	std::string params;
+	irc::ScratchString modes("+", irc::scratch());
+	irc::ScratchString params(irc::scratch());
 
 	if (channel->isInviteOnly()) modes += "i";
 	if (channel->isTopicLocked()) modes += "t";
@@ -59,7 +62,7 @@ void CommandHandler::sendChannelModeReply(Client& client, Channel* channel, cons
 			params += " ";
 		params += std::to_string(channel->getUserLimit());
 	}
-	Response::sendResponseCode(Response::RPL_CHANNELMODEIS, client, {{"channel", channelName}, {"mode", modes}, {"mode params", params}});
+	Response::sendResponseCode(Response::RPL_CHANNELMODEIS, client, {{Field::CHANNEL, channelName}, {Field::MODE, modes}, {Field::MODE_PARAMS, params}});
 }
 
 /**
@@ -99,7 +102,7 @@ bool	CommandHandler::parseChannelModes(Client& client, const Command& cmd, std::
 	return true;
 }
 
-bool	CommandHandler::constructModeNodes( Client& client, const Command& cmd, const std::string& tokens, size_t& paramIndex, std::vector<Mode>& modes )
+bool	CommandHandler::constructModeNodes( Client& client, const Command& cmd, std::string_view tokens, size_t& paramIndex, std::vector<Mode>& modes )
 {
 	bool	adding = true;
 	for ( size_t idx = 0; idx < tokens.length(); ++idx )
@@ -137,7 +140,7 @@ bool	CommandHandler::constructModeNodes( Client& client, const Command& cmd, con
 				{
 					if ( paramIndex >= cmd.params.size() || cmd.params[paramIndex].empty() )
 					{
-						Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{"command", "MODE"}});
+						Response::sendResponseCode(Response::ERR_NEEDMOREPARAMS, client, {{Field::COMMAND, "MODE"}});
 						return false;
 					}
 					param = cmd.params[paramIndex++];
@@ -147,7 +150,7 @@ bool	CommandHandler::constructModeNodes( Client& client, const Command& cmd, con
 		}
 		else
 		{
-			Response::sendResponseCode(Response::ERR_UNKNOWNMODE, client, {{"mode", std::to_string(mode)}});
+			Response::sendResponseCode(Response::ERR_UNKNOWNMODE, client, {{Field::MODE, std::to_string(mode)}});
 			return false;
 		}
 	}
@@ -177,8 +180,8 @@ void CommandHandler::applyChannelModes(Client& client, Channel& channel, std::ve
 	if (modes.empty())
 		return;
 	// 2. Setting up strings to build the broadcast message
-	std::string appliedModeStr;
-	std::string appliedParams;
+	irc::ScratchString appliedModeStr(irc::scratch());
+	irc::ScratchString appliedParams(irc::scratch());
 
 	bool signHasBeenSet = false;
 	bool currentSign = true; // This bool tracks the last sign (+/-) added to the mode string
@@ -213,13 +216,16 @@ void CommandHandler::applyChannelModes(Client& client, Channel& channel, std::ve
 			case 'o':
 				{
 					Client* target = _server.findUser(currentMode.param);
-					if (target)
+					if (target && channel.isMember(target->getHandle()))
 					{
-						if (currentMode.adding) channel.addOperator(target->getFd());
-						else channel.removeOperator(target->getFd());
+						if (currentMode.adding) channel.addOperator(target->getHandle());
+						else channel.removeOperator(target->getHandle());
 					}
 					else
 					{
+						if (target) // Only members can be given or lose operator status
+							Response::sendResponseCode(Response::ERR_USERNOTINCHANNEL, client, {{Field::TARGET, target->getNickname()}, \
+																								{Field::CHANNEL, channel.getName()}});
 						failureState = true;
 					}
 					break;
@@ -246,5 +252,7 @@ void CommandHandler::applyChannelModes(Client& client, Channel& channel, std::ve
 		}
 	}
 
-	broadcastMode(client, channel, appliedModeStr + appliedParams);
+	if (appliedModeStr.empty()) // Every change was refused, there is nothing to announce
+		return;
+	broadcastMode(client, channel, irc::concat(appliedModeStr, appliedParams));
 }
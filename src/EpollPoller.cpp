@@ -0,0 +1,123 @@
+#include "EpollPoller.hpp"
+#include "constants.hpp"
+
+/// Constructors and destructors
+
+EpollPoller::EpollPoller() :
+	_epollFd( epoll_create1( EPOLL_CLOEXEC ) ),
+	_events( irc::MAX_POLL_EVENTS )
+{
+	if ( _epollFd < 0 )
+		throw ( std::runtime_error("Error: failed to create epoll instance.") );
+}
+
+EpollPoller::~EpollPoller()
+{
+	if ( _epollFd >= 0 )
+		close( _epollFd );
+}
+
+
+/// Registration
+
+bool	EpollPoller::add( int fd, short events, void* data, bool edgeTriggered )
+{
+	if ( fd < 0 )
+		return ( false );
+
+	if ( static_cast<size_t>(fd) >= _entries.size() )
+		_entries.resize( fd + 1 );
+
+	Entry&		entry = _entries[fd];
+	epoll_event	event = {};
+
+	entry.flags = edgeTriggered ? static_cast<uint32_t>(EPOLLET) : 0;
+	event.events = toEpoll( events ) | entry.flags;
+	event.data.fd = fd;
+
+	if ( epoll_ctl( _epollFd, EPOLL_CTL_ADD, fd, &event ) < 0 )
+		return ( false );
+
+	entry.data = data;
+	entry.registered = true;
+	return ( true );
+}
+
+bool	EpollPoller::modify( int fd, short events )
+{
+	if ( fd < 0 || static_cast<size_t>(fd) >= _entries.size() || !_entries[fd].registered )
+		return ( false );
+
+	epoll_event	event = {};
+
+	event.events = toEpoll( events ) | _entries[fd].flags;
+	event.data.fd = fd;
+
+	return ( epoll_ctl( _epollFd, EPOLL_CTL_MOD, fd, &event ) == 0 );
+}
+
+void	EpollPoller::remove( int fd )
+{
+	if ( fd < 0 || static_cast<size_t>(fd) >= _entries.size() || !_entries[fd].registered )
+		return ;
+
+	epoll_ctl( _epollFd, EPOLL_CTL_DEL, fd, nullptr );
+	_entries[fd] = Entry();
+}
+
+
+/// Waiting
+
+/**
+ * @brief Waits for readiness. Only the ready fds are returned by the kernel,
+ * and each one is mapped back to its registered data through the fd-indexed entry table.
+ *
+ * @param[out] ready Cleared and filled with the ready fds.
+ * @param timeoutMillis Maximum time to block, -1 blocks indefinitely.
+ * @return Number of ready fds, or -1 on error with errno set.
+ */
+int	EpollPoller::wait( std::vector<PollEvent>& ready, int timeoutMillis )
+{
+	ready.clear();
+
+	int result = epoll_wait( _epollFd, _events.data(), static_cast<int>(_events.size()), timeoutMillis );
+	if ( result <= 0 )
+		return ( result );
+
+	for ( int idx = 0; idx < result; ++idx )
+	{
+		int fd = _events[idx].data.fd;
+		ready.push_back( { fd, fromEpoll( _events[idx].events ), _entries[fd].data } );
+	}
+
+	// A full batch means more events are likely waiting, grow for the next call
+	if ( static_cast<size_t>(result) == _events.size() )
+		_events.resize( _events.size() * 2 );
+
+	return ( result );
+}
+
+const char*	EpollPoller::name() const noexcept { return ( "epoll" ); }
+
+
+/// Static helper functions
+
+uint32_t	EpollPoller::toEpoll( short events ) noexcept
+{
+	uint32_t	result = 0;
+
+	if ( events & POLLIN )	result |= EPOLLIN;
+	if ( events & POLLOUT )	result |= EPOLLOUT;
+	return ( result | EPOLLRDHUP );
+}
+
+short	EpollPoller::fromEpoll( uint32_t events ) noexcept
+{
+	short	result = 0;
+
+	if ( events & EPOLLIN )						result |= POLLIN;
+	if ( events & EPOLLOUT )					result |= POLLOUT;
+	if ( events & EPOLLERR )					result |= POLLERR;
+	if ( events & ( EPOLLHUP | EPOLLRDHUP ) )	result |= POLLHUP;
+	return ( result );
+}
@@ -0,0 +1,609 @@
+#include "IoUringPoller.hpp"
+#include "constants.hpp"
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+
+namespace
+{
+	constexpr const uint16_t	BUFFER_GROUP		= 0;
+
+	// user_data layout: [ request : 8 | generation : 24 | fd : 32 ]
+	constexpr const int			REQUEST_SHIFT		= 56;
+	constexpr const int			GENERATION_SHIFT	= 32;
+	constexpr const uint32_t	GENERATION_MASK		= 0xFFFFFF;
+
+	int	ioUringSetup( unsigned entries, io_uring_params* params )
+	{
+		return ( static_cast<int>(syscall( __NR_io_uring_setup, entries, params )) );
+	}
+
+	int	ioUringEnter( int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize )
+	{
+		return ( static_cast<int>(syscall( __NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, argSize )) );
+	}
+}
+
+/// Constructors and destructors
+
+IoUringPoller::IoUringPoller() :
+	_ringFd( -1 ),
+	_sqRing( MAP_FAILED ),
+	_cqRing( MAP_FAILED ),
+	_sqes( static_cast<io_uring_sqe*>(MAP_FAILED) ),
+	_sqRingSize( 0 ),
+	_cqRingSize( 0 ),
+	_sqesSize( 0 ),
+	_pending( 0 ),
+	_buffers( irc::IO_URING_BUFFER_COUNT * irc::IO_URING_BUFFER_SIZE )
+{
+	io_uring_params	params = {};
+
+	params.flags = IORING_SETUP_CQSIZE;
+	params.cq_entries = irc::IO_URING_ENTRIES * 4;
+
+	_ringFd = ioUringSetup( irc::IO_URING_ENTRIES, &params );
+	if ( _ringFd < 0 )
+		throw ( std::runtime_error("Error: failed to create io_uring instance.") );
+
+	if ( !( params.features & IORING_FEAT_EXT_ARG ) || !( params.features & IORING_FEAT_NODROP ) )
+	{
+		close( _ringFd );
+		throw ( std::runtime_error("Error: io_uring is missing required kernel features.") );
+	}
+
+	_sqRingSize	= params.sq_off.array + params.sq_entries * sizeof( unsigned );
+	_cqRingSize	= params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe );
+	_sqesSize	= params.sq_entries * sizeof( io_uring_sqe );
+
+	if ( params.features & IORING_FEAT_SINGLE_MMAP )
+		_sqRingSize = _cqRingSize = std::max( _sqRingSize, _cqRingSize );
+
+	_sqRing = mmap( nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING );
+	if ( params.features & IORING_FEAT_SINGLE_MMAP )
+		_cqRing = _sqRing;
+	else if ( _sqRing != MAP_FAILED )
+		_cqRing = mmap( nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_CQ_RING );
+	if ( _cqRing != MAP_FAILED )
+		_sqes = static_cast<io_uring_sqe*>(mmap( nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES ));
+
+	if ( _sqRing == MAP_FAILED || _cqRing == MAP_FAILED || _sqes == MAP_FAILED )
+	{
+		unmapRings();
+		close( _ringFd );
+		throw ( std::runtime_error("Error: failed to map io_uring rings.") );
+	}
+
+	char* sq = static_cast<char*>(_sqRing);
+	char* cq = static_cast<char*>(_cqRing);
+
+	_sqHead		= reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+	_sqTail		= reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+	_sqMask		= reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+	_sqArray	= reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+	_sqEntries	= params.sq_entries;
+	_cqHead		= reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+	_cqTail		= reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+	_cqMask		= reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+	_cqes		= reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+	if ( !probeMultishot() )
+	{
+		unmapRings();
+		close( _ringFd );
+		throw ( std::runtime_error("Error: io_uring is missing multishot accept or recv.") );
+	}
+
+	// Hand every receive buffer to the kernel with the first submission
+	queueBuffers( 0, irc::IO_URING_BUFFER_COUNT );
+}
+
+/**
+ * @brief Checks for multishot accept (Linux 5.19) and multishot recv (Linux 6.0), which the ring
+ * features do not reveal. Both requests are tried on throwaway sockets and cancelled right away,
+ * an older kernel fails them with -EINVAL.
+ */
+bool	IoUringPoller::probeMultishot()
+{
+	int			pair[2]		= { -1, -1 };
+	int			listener	= socket( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0 );
+	sockaddr_un	address		= {};
+	bool		supported	= true;
+	unsigned	finished	= 0;
+
+	// Binding only the family autobinds an abstract address, nothing is created on the filesystem
+	address.sun_family = AF_UNIX;
+	if ( listener < 0 || bind( listener, reinterpret_cast<sockaddr*>(&address), sizeof( sa_family_t ) ) < 0
+		|| listen( listener, 1 ) < 0 || socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair ) < 0 )
+		supported = false;
+
+	if ( supported )
+	{
+		queueAccept( listener );
+		queueRecv( pair[0] );
+		queueCancel( userData( REQ_ACCEPT, listener ) );
+		queueCancel( userData( REQ_RECV, pair[0] ) );
+
+		// Both requests end without IORING_CQE_F_MORE, cancelled or failed
+		while ( finished < 2 && submit( 1, 1000 ) >= 0 )
+		{
+			unsigned head = *_cqHead;
+			unsigned tail = __atomic_load_n( _cqTail, __ATOMIC_ACQUIRE );
+
+			for ( ; head != tail; ++head )
+			{
+				const io_uring_cqe&	cqe		= _cqes[head & *_cqMask];
+				Request				request	= static_cast<Request>(cqe.user_data >> REQUEST_SHIFT);
+
+				if ( request != REQ_ACCEPT && request != REQ_RECV )
+					continue ;
+				if ( cqe.res == -EINVAL )
+					supported = false;
+				else if ( request == REQ_ACCEPT && cqe.res >= 0 )
+					close( cqe.res );
+				if ( !( cqe.flags & IORING_CQE_F_MORE ) )
+					++finished;
+			}
+			__atomic_store_n( _cqHead, head, __ATOMIC_RELEASE );
+		}
+	}
+
+	for ( int fd : { listener, pair[0], pair[1] } )
+	{
+		if ( fd >= 0 )
+			close( fd );
+	}
+	return ( supported && finished == 2 );
+}
+
+IoUringPoller::~IoUringPoller()
+{
+	unmapRings();
+	if ( _ringFd >= 0 )
+		close( _ringFd );
+}
+
+
+/// Registration
+
+bool	IoUringPoller::add( int fd, short events, void* data, [[maybe_unused]] bool edgeTriggered )
+{
+	if ( fd < 0 )
+		return ( false );
+
+	if ( static_cast<size_t>(fd) >= _entries.size() )
+		_entries.resize( fd + 1 );
+
+	Entry&		entry		= _entries[fd];
+	int			listening	= 0;
+	socklen_t	length		= sizeof( listening );
+
+	entry.data			= data;
+	entry.registered	= true;
+	entry.polloutArmed	= false;
+	entry.polloutWanted	= events & POLLOUT;
+	entry.socket		= getsockopt( fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &length ) == 0;
+	entry.listener		= entry.socket && listening;
+
+	if ( events & POLLIN )
+	{
+		if ( entry.listener )
+			queueAccept( fd );
+		else if ( entry.socket )
+		{
+			entry.recvArmed = true;
+			queueRecv( fd );
+		}
+		else
+			queuePollin( fd );
+	}
+	if ( events & POLLOUT )
+		queuePollout( fd );
+
+	return ( true );
+}
+
+bool	IoUringPoller::modify( int fd, short events )
+{
+	if ( fd < 0 || static_cast<size_t>(fd) >= _entries.size() || !_entries[fd].registered )
+		return ( false );
+
+	Entry& entry = _entries[fd];
+
+	// Reads stay armed through the multishot request, pausing them cancels it and resuming queues a new one
+	if ( entry.socket && !entry.listener && ( events & POLLIN ) && !entry.recvArmed )
+	{
+		entry.recvArmed = true;
+		queueRecv( fd );
+	}
+	else if ( entry.socket && !entry.listener && !( events & POLLIN ) && entry.recvArmed )
+	{
+		entry.recvArmed = false;
+		queueCancel( userData( REQ_RECV, fd ) );
+	}
+
+	entry.polloutWanted = events & POLLOUT;
+	if ( entry.polloutWanted && !entry.polloutArmed )
+		queuePollout( fd );
+
+	return ( true );
+}
+
+/**
+ * @brief Cancels every request on the fd. Cancellation goes by user_data rather than by fd,
+ * so it stays correct even if the fd number is reused before the cancel is submitted.
+ * Completions still in flight for the old registration are discarded by their generation.
+ */
+void	IoUringPoller::remove( int fd )
+{
+	if ( fd < 0 || static_cast<size_t>(fd) >= _entries.size() || !_entries[fd].registered )
+		return ;
+
+	Entry& entry = _entries[fd];
+
+	queueCancel( userData( entry.listener ? REQ_ACCEPT : entry.socket ? REQ_RECV : REQ_POLLIN, fd ) );
+	if ( entry.polloutArmed )
+		queueCancel( userData( REQ_POLLOUT, fd ) );
+	if ( entry.sendArmed ) // The request holds the socket open until it completes
+		queueCancel( userData( REQ_SEND, fd ) );
+
+	uint32_t generation = ( entry.generation + 1 ) & GENERATION_MASK;
+	entry = Entry();
+	entry.generation = generation;
+}
+
+
+/// Waiting
+
+/**
+ * @brief Submits every queued request and waits for completions in one system call.
+ * Receive buffers handed out by the previous call are given back to the kernel first.
+ *
+ * @param[out] ready Cleared and filled with the completed operations.
+ * @param timeoutMillis Maximum time to block, -1 blocks indefinitely.
+ * @return Number of events, or -1 on error with errno set.
+ */
+int	IoUringPoller::wait( std::vector<PollEvent>& ready, int timeoutMillis )
+{
+	ready.clear();
+
+	for ( uint16_t bufferId : _recycle )
+		queueBuffers( bufferId, 1 );
+	_recycle.clear();
+
+	// Re-armed only now, after the owner had the chance to write until the socket was full again
+	for ( int fd : _rearm )
+	{
+		if ( _entries[fd].registered && _entries[fd].polloutWanted && !_entries[fd].polloutArmed )
+			queuePollout( fd );
+	}
+	_rearm.clear();
+
+	// Failed accepts are retried after a delay, an accept failing at the descriptor limit would fail again at once
+	auto now = std::chrono::steady_clock::now();
+	std::erase_if( _acceptRetries, [this, now, &timeoutMillis]( const AcceptRetry& retry )
+	{
+		if ( retry.due > now )
+		{
+			int remaining = static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>( retry.due - now ).count());
+			if ( timeoutMillis < 0 || remaining < timeoutMillis )
+				timeoutMillis = remaining;
+			return ( false );
+		}
+		if ( _entries[retry.fd].registered && _entries[retry.fd].generation == retry.generation )
+			queueAccept( retry.fd );
+		return ( true );
+	} );
+
+	if ( submit( 1, timeoutMillis ) < 0 )
+	{
+		if ( errno == ETIME || errno == EBUSY )
+			return ( 0 );
+		return ( -1 );
+	}
+
+	unsigned head = *_cqHead;
+	unsigned tail = __atomic_load_n( _cqTail, __ATOMIC_ACQUIRE );
+
+	for ( ; head != tail; ++head )
+	{
+		const io_uring_cqe&	cqe			= _cqes[head & *_cqMask];
+		Request				request		= static_cast<Request>(cqe.user_data >> REQUEST_SHIFT);
+		uint32_t			generation	= ( cqe.user_data >> GENERATION_SHIFT ) & GENERATION_MASK;
+		int					fd			= static_cast<int>(cqe.user_data & 0xFFFFFFFF);
+		bool				more		= cqe.flags & IORING_CQE_F_MORE;
+
+		if ( request == REQ_SEND ) // The blocks are released even if the fd was removed meanwhile
+			finishSend( cqe.user_data );
+		if ( request == REQ_IGNORED || static_cast<size_t>(fd) >= _entries.size() )
+			continue ;
+
+		Entry& entry = _entries[fd];
+		if ( !entry.registered || entry.generation != generation )
+		{
+			// Completion for a removed fd, only its buffer is still of use
+			if ( cqe.flags & IORING_CQE_F_BUFFER )
+				_recycle.push_back( cqe.flags >> IORING_CQE_BUFFER_SHIFT );
+			continue ;
+		}
+
+		switch ( request )
+		{
+			case REQ_ACCEPT:
+				if ( cqe.res != -ECANCELED )
+					ready.push_back( { fd, POLLIN, entry.data, true, cqe.res, nullptr } );
+				if ( more )
+					break ;
+				if ( cqe.res < 0 && cqe.res != -ECANCELED )
+					_acceptRetries.push_back( { fd, generation, std::chrono::steady_clock::now() + std::chrono::milliseconds( irc::IO_URING_ACCEPT_RETRY_MILLIS ) } );
+				else
+					queueAccept( fd );
+				break ;
+
+			case REQ_RECV:
+				if ( cqe.res > 0 )
+				{
+					uint16_t bufferId = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+					_recycle.push_back( bufferId );
+					ready.push_back( { fd, POLLIN, entry.data, true, cqe.res, &_buffers[bufferId * irc::IO_URING_BUFFER_SIZE] } );
+					if ( !more && entry.recvArmed )
+						queueRecv( fd );
+				}
+				else if ( cqe.res == -ENOBUFS ) // Buffers are returned on the next call
+				{
+					if ( entry.recvArmed )
+						queueRecv( fd );
+				}
+				else if ( cqe.res == -ECANCELED ) // Reads were paused
+					break ;
+				else if ( cqe.res == 0 )
+					ready.push_back( { fd, POLLIN, entry.data, true, 0, nullptr } );
+				else
+					ready.push_back( { fd, POLLERR, entry.data, true, cqe.res, nullptr } );
+				break ;
+
+			case REQ_POLLIN:
+				if ( cqe.res > 0 )
+					ready.push_back( { fd, static_cast<short>(cqe.res), entry.data } );
+				if ( !more )
+					queuePollin( fd );
+				break ;
+
+			case REQ_POLLOUT:
+				entry.polloutArmed = false;
+				if ( !entry.polloutWanted ) // POLLOUT was dropped meanwhile
+					break ;
+				if ( cqe.res > 0 )
+					ready.push_back( { fd, static_cast<short>(cqe.res), entry.data } );
+				_rearm.push_back( fd );
+				break ;
+
+			case REQ_SEND:
+				entry.sendArmed = false;
+				ready.push_back( { fd, POLLOUT, entry.data, true, cqe.res, nullptr } );
+				break ;
+
+			default:
+				break ;
+		}
+	}
+	__atomic_store_n( _cqHead, head, __ATOMIC_RELEASE );
+
+	return ( static_cast<int>(ready.size()) );
+}
+
+const char*	IoUringPoller::name() const noexcept { return ( "io_uring" ); }
+
+
+/// Sending
+
+/**
+ * @brief Queues one gathered sendmsg of the blocks, submitted with the next wait.
+ * The blocks are referenced by the request, so the caller may drop them from its queue
+ * before the write completes. Only one write per socket is in flight at a time.
+ *
+ * @return true if the write was queued, false if the fd is unknown or already writing.
+ */
+bool	IoUringPoller::send( int fd, std::span<const MessageBlock> blocks, size_t offset )
+{
+	if ( fd < 0 || static_cast<size_t>(fd) >= _entries.size() || !_entries[fd].registered || _entries[fd].sendArmed )
+		return ( false );
+	if ( blocks.empty() || blocks.size() > irc::MAX_SEND_VECTORS )
+		return ( false );
+
+	uint64_t	key = userData( REQ_SEND, fd );
+
+	SendTable::iterator	slot;
+
+	if ( _spareSends.empty() )
+		slot = _sends.try_emplace( key ).first;
+	else
+	{
+		SendTable::node_type node = std::move( _spareSends.back() );
+		_spareSends.pop_back();
+		node.key() = key;
+		slot = _sends.insert( std::move( node ) ).position;
+	}
+
+	Send& request = slot->second;
+	for ( size_t idx = 0; idx < blocks.size(); ++idx )
+	{
+		request.blocks[idx]				= blocks[idx];
+		request.vectors[idx].iov_base	= const_cast<char*>( blocks[idx]->data() + offset );
+		request.vectors[idx].iov_len	= blocks[idx]->length() - offset;
+		offset = 0;
+	}
+	request.header				= {};
+	request.header.msg_iov		= request.vectors.data();
+	request.header.msg_iovlen	= blocks.size();
+
+	io_uring_sqe* sqe = nextSqe();
+
+	sqe->opcode		= IORING_OP_SENDMSG;
+	sqe->fd			= fd;
+	sqe->addr		= reinterpret_cast<uint64_t>( &request.header );
+	sqe->len		= 1;
+	sqe->msg_flags	= MSG_NOSIGNAL;
+	sqe->user_data	= key;
+
+	_entries[fd].sendArmed = true;
+	return ( true );
+}
+
+/**
+ * @brief Drops the references of a completed write and keeps its node for the next one.
+ */
+void	IoUringPoller::finishSend( uint64_t key )
+{
+	SendTable::node_type node = _sends.extract( key );
+
+	if ( node.empty() )
+		return ;
+	node.mapped().blocks.fill( nullptr );
+	_spareSends.push_back( std::move( node ) );
+}
+
+
+/// Submission helpers
+
+/**
+ * @brief Returns the next free submission entry. When the queue is full the pending
+ * entries are submitted early, which is the only case where a tick needs a second system call.
+ */
+io_uring_sqe*	IoUringPoller::nextSqe()
+{
+	unsigned head = __atomic_load_n( _sqHead, __ATOMIC_ACQUIRE );
+	unsigned tail = *_sqTail;
+
+	if ( tail - head >= _sqEntries )
+	{
+		submit( 0, 0 );
+		head = __atomic_load_n( _sqHead, __ATOMIC_ACQUIRE );
+	}
+
+	unsigned		index	= tail & *_sqMask;
+	io_uring_sqe*	sqe		= &_sqes[index];
+
+	std::memset( sqe, 0, sizeof( *sqe ) );
+	_sqArray[index] = index;
+	__atomic_store_n( _sqTail, tail + 1, __ATOMIC_RELEASE );
+	++_pending;
+
+	return ( sqe );
+}
+
+int	IoUringPoller::submit( unsigned waitFor, int timeoutMillis )
+{
+	io_uring_getevents_arg	arg = {};
+	__kernel_timespec		timeout = {};
+	unsigned				flags = 0;
+
+	if ( waitFor > 0 )
+	{
+		flags |= IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+		arg.sigmask_sz = _NSIG / 8;
+		if ( timeoutMillis >= 0 )
+		{
+			timeout.tv_sec = timeoutMillis / 1000;
+			timeout.tv_nsec = ( timeoutMillis % 1000 ) * 1000000L;
+			arg.ts = reinterpret_cast<uint64_t>(&timeout);
+		}
+	}
+
+	int result = ioUringEnter( _ringFd, _pending, waitFor, flags, waitFor > 0 ? &arg : nullptr, waitFor > 0 ? sizeof( arg ) : 0 );
+	if ( result >= 0 )
+		_pending = ( static_cast<unsigned>(result) < _pending ) ? _pending - result : 0;
+	return ( result );
+}
+
+void	IoUringPoller::queueAccept( int fd )
+{
+	io_uring_sqe* sqe = nextSqe();
+
+	sqe->opcode			= IORING_OP_ACCEPT;
+	sqe->fd				= fd;
+	sqe->ioprio			= IORING_ACCEPT_MULTISHOT;
+	sqe->accept_flags	= SOCK_NONBLOCK | SOCK_CLOEXEC;
+	sqe->user_data		= userData( REQ_ACCEPT, fd );
+}
+
+void	IoUringPoller::queueRecv( int fd )
+{
+	io_uring_sqe* sqe = nextSqe();
+
+	sqe->opcode		= IORING_OP_RECV;
+	sqe->fd			= fd;
+	sqe->ioprio		= IORING_RECV_MULTISHOT;
+	sqe->flags		= IOSQE_BUFFER_SELECT;
+	sqe->buf_group	= BUFFER_GROUP;
+	sqe->user_data	= userData( REQ_RECV, fd );
+}
+
+void	IoUringPoller::queuePollin( int fd )
+{
+	io_uring_sqe* sqe = nextSqe();
+
+	sqe->opcode			= IORING_OP_POLL_ADD;
+	sqe->fd				= fd;
+	sqe->len			= IORING_POLL_ADD_MULTI;
+	sqe->poll32_events	= POLLIN;
+	sqe->user_data		= userData( REQ_POLLIN, fd );
+}
+
+void	IoUringPoller::queuePollout( int fd )
+{
+	io_uring_sqe* sqe = nextSqe();
+
+	sqe->opcode			= IORING_OP_POLL_ADD;
+	sqe->fd				= fd;
+	sqe->poll32_events	= POLLOUT;
+	sqe->user_data		= userData( REQ_POLLOUT, fd );
+
+	_entries[fd].polloutArmed = true;
+}
+
+void	IoUringPoller::queueCancel( uint64_t target )
+{
+	io_uring_sqe* sqe = nextSqe();
+
+	sqe->opcode		= IORING_OP_ASYNC_CANCEL;
+	sqe->fd			= -1;
+	sqe->addr		= target;
+	sqe->user_data	= static_cast<uint64_t>(REQ_IGNORED) << REQUEST_SHIFT;
+}
+
+void	IoUringPoller::queueBuffers( uint16_t bufferId, unsigned count )
+{
+	io_uring_sqe* sqe = nextSqe();
+
+	sqe->opcode		= IORING_OP_PROVIDE_BUFFERS;
+	sqe->fd			= static_cast<int>(count);
+	sqe->addr		= reinterpret_cast<uint64_t>(&_buffers[bufferId * irc::IO_URING_BUFFER_SIZE]);
+	sqe->len		= irc::IO_URING_BUFFER_SIZE;
+	sqe->off		= bufferId;
+	sqe->buf_group	= BUFFER_GROUP;
+	sqe->user_data	= static_cast<uint64_t>(REQ_IGNORED) << REQUEST_SHIFT;
+}
+
+uint64_t	IoUringPoller::userData( Request request, int fd ) const noexcept
+{
+	uint64_t generation = static_cast<size_t>(fd) < _entries.size() ? _entries[fd].generation : 0;
+
+	return ( static_cast<uint64_t>(request) << REQUEST_SHIFT
+			| generation << GENERATION_SHIFT
+			| static_cast<uint32_t>(fd) );
+}
+
+void	IoUringPoller::unmapRings() noexcept
+{
+	if ( _sqes != MAP_FAILED )
+		munmap( _sqes, _sqesSize );
+	if ( _cqRing != MAP_FAILED && _cqRing != _sqRing )
+		munmap( _cqRing, _cqRingSize );
+	if ( _sqRing != MAP_FAILED )
+		munmap( _sqRing, _sqRingSize );
+}
@@ -29,13 +29,18 @@ std::string	Logger::timestamp()
  * @param func Name of the event which occurred.
  * @param status The status of the event: SUCCESS, FAIL, DEBUG or INFO.
  * @param msg The message accompanied by the event.
+ * The line is written piece by piece, logging does not build any strings.
  */
-void	Logger::log( const std::string& func, const std::string& status, const std::string& msg )
+void	Logger::log( std::string_view func, std::string_view status, std::string_view msg )
 {
-	std::string	time		= timestamp();
-	std::string eventName	= func;
+	using sysclock = std::chrono::system_clock;
+	const std::time_t	cTime = sysclock::to_time_t( sysclock::now() );
+	std::tm				localTime;
+	char				time[32];
 
-	eventName.resize(_functionLength, ' ');
+	localtime_r( &cTime, &localTime );
+	std::strftime( time, sizeof( time ), "%F %T", &localTime );
 
-	std::cout << time << " [" << status << "]" << " [" << eventName << "] " << msg << std::endl;
+	std::lock_guard<std::mutex> lock( _outputMutex ); // Event loop threads share the console
+	std::cout << time << " [" << status << "]" << " [" << std::left << std::setw( _functionLength ) << func.substr( 0, _functionLength ) << "] " << msg << std::endl;
 }
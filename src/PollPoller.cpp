@@ -0,0 +1,86 @@
+#include "PollPoller.hpp"
+
+/// Registration
+
+bool	PollPoller::add( int fd, short events, void* data, [[maybe_unused]] bool edgeTriggered )
+{
+	if ( fd < 0 )
+		return ( false );
+
+	if ( static_cast<size_t>(fd) >= _slots.size() )
+	{
+		_slots.resize( fd + 1, NO_SLOT );
+		_data.resize( fd + 1, nullptr );
+	}
+	if ( _slots[fd] != NO_SLOT )
+		return ( false );
+
+	pollfd	entry;
+	entry.fd = fd;
+	entry.events = events;
+	entry.revents = 0;
+
+	_slots[fd] = _fds.size();
+	_data[fd] = data;
+	_fds.push_back( entry );
+
+	return ( true );
+}
+
+bool	PollPoller::modify( int fd, short events )
+{
+	if ( fd < 0 || static_cast<size_t>(fd) >= _slots.size() || _slots[fd] == NO_SLOT )
+		return ( false );
+
+	_fds[_slots[fd]].events = events;
+	return ( true );
+}
+
+/**
+ * @brief Removes the fd by moving the last pollfd into its slot.
+ */
+void	PollPoller::remove( int fd )
+{
+	if ( fd < 0 || static_cast<size_t>(fd) >= _slots.size() || _slots[fd] == NO_SLOT )
+		return ;
+
+	size_t slot = _slots[fd];
+
+	if ( slot != _fds.size() - 1 )
+	{
+		_fds[slot] = _fds.back();
+		_slots[_fds[slot].fd] = slot;
+	}
+	_fds.pop_back();
+
+	_slots[fd] = NO_SLOT;
+	_data[fd] = nullptr;
+}
+
+
+/// Waiting
+
+/**
+ * @brief Waits for readiness and collects every fd with pending events.
+ *
+ * @param[out] ready Cleared and filled with the ready fds.
+ * @param timeoutMillis Maximum time to block, -1 blocks indefinitely.
+ * @return Number of ready fds, or -1 on error with errno set.
+ */
+int	PollPoller::wait( std::vector<PollEvent>& ready, int timeoutMillis )
+{
+	ready.clear();
+
+	int result = poll( _fds.data(), _fds.size(), timeoutMillis );
+	if ( result <= 0 )
+		return ( result );
+
+	for ( const auto& entry : _fds )
+	{
+		if ( entry.revents != 0 )
+			ready.push_back( { entry.fd, entry.revents, _data[entry.fd] } );
+	}
+	return ( static_cast<int>(ready.size()) );
+}
+
+const char*	PollPoller::name() const noexcept { return ( "poll" ); }
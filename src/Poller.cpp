@@ -0,0 +1,63 @@
+#include "Poller.hpp"
+#include "PollPoller.hpp"
+#include "EpollPoller.hpp"
+#include "IoUringPoller.hpp"
+#include "constants.hpp"
+#include <cstdlib>
+
+/**
+ * @brief Creates the event backend selected at startup.
+ * The environment variable irc::EVENT_BACKEND_ENV takes precedence over irc::EVENT_BACKEND.
+ * An io_uring the kernel cannot fully support falls back to epoll. Falls back to poll when
+ * the backend is unknown or no other backend can be initialized on this host.
+ *
+ * @return Owning pointer to the backend.
+ */
+std::unique_ptr<Poller>	Poller::create()
+{
+	const char*	override	= std::getenv( irc::EVENT_BACKEND_ENV );
+	std::string	backend		= override ? override : irc::EVENT_BACKEND;
+
+	if ( backend == "io_uring" )
+	{
+		try
+		{
+			return ( std::make_unique<IoUringPoller>() );
+		}
+		catch ( const std::exception& e )
+		{
+			irc::log_event("SERVER", irc::LOG_FAIL, std::string(e.what()) + ", falling back to epoll");
+			backend = "epoll";
+		}
+	}
+
+	try
+	{
+		if ( backend == "epoll" )
+			return ( std::make_unique<EpollPoller>() );
+	}
+	catch ( const std::exception& e )
+	{
+		irc::log_event("SERVER", irc::LOG_FAIL, std::string(e.what()) + ", falling back to poll");
+		return ( std::make_unique<PollPoller>() );
+	}
+
+	if ( backend != "poll" )
+	{
+		irc::log_event("SERVER", irc::LOG_FAIL, "unknown event backend " + backend + ", falling back to poll");
+	}
+	return ( std::make_unique<PollPoller>() );
+}
+
+/**
+ * @brief Starts writing the blocks to the socket, beginning offset bytes into the first one.
+ * Readiness backends leave the writing to the caller and return false.
+ * A backend which writes itself keeps the blocks alive until the write completes,
+ * and reports it as a completed POLLOUT event.
+ *
+ * @return true if the write was started, false if the caller has to write.
+ */
+bool	Poller::send( [[maybe_unused]] int fd, [[maybe_unused]] std::span<const MessageBlock> blocks, [[maybe_unused]] size_t offset )
+{
+	return ( false );
+}
@@ -0,0 +1,90 @@
+#include "ReceiveBuffer.hpp"
+#include "constants.hpp"
+#include "ByteScan.hpp"
+#include <cstring>
+
+/// Constructors and destructors
+
+ReceiveBuffer::ReceiveBuffer( std::pmr::memory_resource* resource ) :
+	_data( resource ),
+	_begin( 0 ),
+	_end( 0 ),
+	_scanned( 0 )
+{}
+
+
+/// Writing
+
+/**
+ * @brief Makes room for the next read. Storage is allocated on the first read,
+ * so idle connections hold no input buffer. The unframed tail is only moved
+ * back to the front when less than one protocol message would fit behind it.
+ */
+void	ReceiveBuffer::reserve()
+{
+	if ( _data.empty() )
+		_data.resize( irc::CLIENT_RECEIVE_BUFFER_SIZE );
+
+	if ( _begin == _end )
+	{
+		_begin = _end = _scanned = 0;
+		return ;
+	}
+	if ( _begin == 0 || writeSpace() >= irc::MAX_IRC_MESSAGE_LENGTH )
+		return ;
+
+	std::memmove( _data.data(), _data.data() + _begin, _end - _begin );
+	_end		-= _begin;
+	_scanned	-= _begin;
+	_begin		= 0;
+}
+
+char*	ReceiveBuffer::writeData	() noexcept			{ return _data.data() + _end; }
+size_t	ReceiveBuffer::writeSpace	() const noexcept	{ return _data.size() - _end; }
+void	ReceiveBuffer::commit		( size_t bytes ) noexcept	{ _end += bytes; }
+
+
+/// Framing
+
+/**
+ * @brief Frames the next complete line, without its \\r\\n.
+ * Bytes already scanned by an earlier call are not looked at again.
+ *
+ * @param[out] line View of the line inside the buffer.
+ * @return true if a complete line was found, otherwise false.
+ */
+bool	ReceiveBuffer::nextLine( std::string_view& line ) noexcept
+{
+	const char*	data = _data.data();
+
+	while ( _scanned < _end )
+	{
+		const char* newline = irc::findByte( data + _scanned, data + _end, '\n' );
+
+		if ( newline == data + _end )
+		{
+			_scanned = _end;
+			return false;
+		}
+
+		size_t position = newline - data;
+
+		_scanned = position + 1;
+		if ( position > _begin && data[position - 1] == '\r' )
+		{
+			line	= std::string_view( data + _begin, position - 1 - _begin );
+			_begin	= _scanned;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/// Bookkeeping
+
+/**
+ * @brief Number of received bytes which are not part of a line handed out yet.
+ */
+size_t	ReceiveBuffer::size		() const noexcept	{ return _end - _begin; }
+void	ReceiveBuffer::clear	() noexcept			{ _begin = _end = _scanned = 0; }
@@ -2,13 +2,33 @@
 #include "Server.hpp"
 #include "Client.hpp"
 #include "constants.hpp"
+#include "Command.hpp"
+#include <array>
 
 
 /**
- * @brief Relays a command to specified client. Used in broadcasting messages on a channel.
+ * @brief Relays a command to specified client.
  *
- * Accepted placeholder keys:
- * target, message, channel, reason, new nick, topic, flags
+ * @param command The command successfully ran by thhe source client.
+ * @param source The client who ran the command.
+ * @param target The client who will receive notice on the same channel.
+ * @param args Placeholder values of the command.
+ */
+void	Response::sendResponseCommand( CommandType command, Client& source, Client& target, Args args )
+{
+	MessageBlock responseMessage = renderCommand( command, source, args );
+
+	if ( responseMessage )
+		sendMessage( target, responseMessage );
+}
+
+/**
+ * @brief Renders a relayed command once. The line only depends on the source,
+ * so a broadcast renders it a single time and queues the same block to every member.
+ * The source is the prefix cached by the client, it is not assembled here.
+ *
+ * Accepted placeholder fields:
+ * TARGET, MESSAGE, CHANNEL, REASON, NEW_NICK, TOPIC, FLAGS
  *
  * QUIT: empty reason becomes "Client Quit"
  * PART: empty reason removes the trailing message
@@ -16,133 +36,148 @@
  *
  * @param command The command successfully ran by thhe source client.
  * @param source The client who ran the command.
- * @param target The client who will receive notice on the same channel.
- * @param placeholders Mandatory map of placeholder values.
+ * @param args Placeholder values of the command, unset fields are empty.
+ * @return The rendered line, or nullptr for a command without a template.
  */
-void	Response::sendResponseCommand( const std::string& command, Client& source, Client& target, const string_map& placeholders )
+MessageBlock	Response::renderCommand( CommandType command, Client& source, Args args )
 {
-	std::string	templateMessage = getCommandTemplate( command );
-
-	if ( templateMessage.empty() )
-		return ;
+	FieldValues	values = {};
+	bool		withReason = false;
 
-	string_map fields =
+	for ( const Arg& arg : args )
 	{
-		{ "nick", source.getNickname() },
-		{ "user", source.getUsername() },
-		{ "host", source.getHostname() },
-		{ "target", "" },
-		{ "message", "" },
-		{ "channel", "" },
-		{ "reason", "" },
-		{ "new nick", "" },
-		{ "topic", "" },
-		{ "flags", "" }
-	};
-
-	if ( fields["nick"].empty() )
-		fields["nick"] = "*";
-
-	if ( irc::REVEAL_HOSTNAME && !source.getIpAddress().empty() )
-		fields["host"] = source.getIpAddress();
-
-	for ( const auto& [placeholder, value] : placeholders )
-	{
-		fields[placeholder] = value;
+		if ( arg.field == Field::REASON && !arg.value.empty() )
+			withReason = true;
 	}
 
-	if ( command == "QUIT" && fields["reason"].empty() )
-		fields["reason"] = "Client Quit";
-	if ( command == "PART" && fields["reason"].empty() )
-	{
-		size_t clrfPos = templateMessage.find_last_of("\r\n");
-		if ( clrfPos != std::string::npos )
-		{
-			size_t colonPos = templateMessage.find_last_of(" :", clrfPos);
-			if ( colonPos != std::string::npos )
-				templateMessage.erase(colonPos, clrfPos - colonPos);
-		}
-	}
+	const ResponseTemplate*	format = getCommandTemplate( command, withReason );
 
-	std::string responseMessage = findAndReplacePlaceholders( templateMessage, fields );
+	if ( format == nullptr )
+		return ( nullptr );
 
-	sendMessage( target, responseMessage );
+	values[static_cast<size_t>(Field::SOURCE)] = source.getPrefix();
+
+	return ( render( *format, values, args ) );
 }
 
 /**
  * @brief Sends a forrmatted response to the client specified by the client fd.
  * Client may be modified if an error occurs when sending a message.
  *
- * Accepted placeholder keys:
- * target, command, channel, users, names, topic, user modes, channel modes,
- * symbol, real name, server info, text, new nick, param, value
+ * Accepted placeholder fields:
+ * TARGET, COMMAND, CHANNEL, USERS, NAMES, TOPIC, USER_MODES, CHANNEL_MODES,
+ * SYMBOL, REAL_NAME, SERVER_INFO, TEXT, NEW_NICK, PARAM, VALUE, MODE, MODE_PARAMS
  *
  * @param code The response code to send.
  * @param client The client who will receive the response. Nick, user and host placeholders are fetched from this.
- * @param placeholders Optional map of additional placeholder values.
+ * @param args Optional placeholder values, unset fields become "*" or "***".
  */
-void	Response::sendResponseCode( int code, Client& client, const string_map& placeholders = {} )
+void	Response::sendResponseCode( int code, Client& client, Args args )
 {
-	constexpr const char* const emptyFieldBasic		= "*";
-	constexpr const char* const emptyFieldComplex	= "***";
-
-	std::string	templateMessage = getResponseTemplate( code );
+	constexpr std::string_view	emptyFieldBasic		= "*";
+	constexpr std::string_view	emptyFieldComplex	= "***";
+
+	const ResponseTemplate*	format = getResponseTemplate( code );
+
+	if ( format == nullptr ) return ;
+
+	std::array<char, 3>	formattedCode = formatCode( code );
+	FieldValues			values;
+
+	values.fill( emptyFieldBasic );
+	values[static_cast<size_t>(Field::CODE)]			= std::string_view( formattedCode.data(), formattedCode.size() );
+	values[static_cast<size_t>(Field::NICK)]			= client.getNickname().empty() ? emptyFieldBasic : client.getNickname();
+	values[static_cast<size_t>(Field::USER)]			= client.getUsername().empty() ? emptyFieldBasic : client.getUsername();
+	values[static_cast<size_t>(Field::HOST)]			= client.getHostname().empty() ? emptyFieldBasic : client.getHostname();
+	values[static_cast<size_t>(Field::DATE)]			= _date;
+	values[static_cast<size_t>(Field::SERVER)]			= _server;
+	values[static_cast<size_t>(Field::VERSION)]			= _version;
+	values[static_cast<size_t>(Field::VALUE)]			= emptyFieldComplex;
+	values[static_cast<size_t>(Field::TEXT)]			= emptyFieldComplex;
+	values[static_cast<size_t>(Field::SERVER_INFO)]		= emptyFieldComplex;
+	values[static_cast<size_t>(Field::USER_MODES)]		= emptyFieldComplex;
+	values[static_cast<size_t>(Field::CHANNEL_MODES)]	= emptyFieldComplex;
+	values[static_cast<size_t>(Field::MODE_PARAMS)]		= emptyFieldComplex;
+
+	sendMessage( client, render( *format, values, args ) );
+}
 
-	if ( templateMessage.empty() ) return ;
+/**
+ * @brief Writes as much of the client's send queue as the socket accepts, gathering
+ * up to irc::MAX_SEND_VECTORS queued messages into each sendmsg call.
+ * sendmsg is used over writev for MSG_NOSIGNAL, a closed peer must not raise SIGPIPE.
+ * Only the shard owning the client writes it.
+ *
+ * @param client The client whose queued messages should be written.
+ * @return false if the connection failed, otherwise true (check hasPendingOutput for leftovers)
+ */
+bool	Response::flushMessages( Client& client )
+{
+	std::array<iovec, irc::MAX_SEND_VECTORS>	vectors;
 
-	string_map fields =
+	if ( client.getSendInFlight() ) // Writing now would interleave with the poller's write
+		return (true);
+	while ( client.hasPendingOutput() )
 	{
-		{ "code", Response::formatCode(code) },
-		{ "nick", ( client.getNickname().empty() ? "*" : client.getNickname() ) },
-		{ "user", ( client.getUsername().empty() ? "*" : client.getUsername() ) },
-		{ "host", ( client.getHostname().empty() ? "*" : client.getHostname() ) },
-		{ "date", _date },
-		{ "server", _server },
-		{ "version", _version },
-		{ "target", emptyFieldBasic },
-		{ "command", emptyFieldBasic },
-		{ "channel", emptyFieldBasic },
-		{ "users", emptyFieldBasic },
-		{ "names", emptyFieldBasic },
-		{ "real name", emptyFieldBasic },
-		{ "new nick", emptyFieldBasic },
-		{ "topic", emptyFieldBasic },
-		{ "symbol", emptyFieldBasic },
-		{ "param", emptyFieldBasic },
-		{ "value", emptyFieldComplex },
-		{ "text", emptyFieldComplex },
-		{ "server info", emptyFieldComplex },
-		{ "user modes", emptyFieldComplex },
-		{ "channel modes", emptyFieldComplex },
-		{ "mode", emptyFieldBasic },
-		{ "mode params", emptyFieldComplex }
-	};
-
-	for ( const auto& [placeholder, value] : placeholders )
-	{
-		fields[placeholder] = value;
-	}
+		msghdr	header = {};
+
+		header.msg_iov		= vectors.data();
+		header.msg_iovlen	= client.fillSendVector( vectors.data(), vectors.size() );
 
-	std::string responseMessage = findAndReplacePlaceholders( templateMessage, fields );
+		size_t	length = 0;
+		for ( size_t idx = 0; idx < header.msg_iovlen; ++idx )
+			length += vectors[idx].iov_len;
 
-	sendMessage( client, responseMessage );
+		ssize_t bytes = sendmsg( client.getFd(), &header, MSG_NOSIGNAL );
+
+		if ( bytes < 0 )
+		{
+			if ( errno == EINTR )
+				continue ;
+			if ( errno == EAGAIN || errno == EWOULDBLOCK )
+				return (true);
+
+			client.clearSendBuffer();
+			if ( client.getActive() )
+			{
+				client.setActive(false);
+				Server::setDisconnectEvent(client);
+			}
+			if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
+				irc::log_event( "SEND", irc::LOG_FAIL, "client has disconnected");
+			return (false);
+		}
+
+		client.consumeSendBuffer( bytes );
+		if ( static_cast<size_t>(bytes) < length ) // Socket buffer is full
+			return (true);
+	}
+	return (true);
 }
 
 /**
- * @brief Sends a buffered partial message to the client.
+ * @brief Hands the front of the client's send queue to its shard's poller when the backend
+ * writes on its own, otherwise writes it right away with flushMessages.
+ * The queue is consumed when the write completes, until then nothing more is submitted.
+ * Only the shard owning the client writes it.
  *
- * @param client The client which should receive the buffered message.
+ * @param client The client whose queued messages should be written.
+ * @return false if the connection failed, otherwise true
  */
-void	Response::sendPartialResponse( Client& client )
+bool	Response::submitMessages( Client& client )
 {
-	std::string bufferedMessage = client.getSendBuffer();
-
-	if ( bufferedMessage.empty() ) return ;
+	if ( client.getSendInFlight() || !client.hasPendingOutput() )
+		return (true);
 
-	client.clearSendBuffer();
-	client.setPollout(false);
+	std::array<MessageBlock, irc::MAX_SEND_VECTORS>	blocks;
+	size_t	count = client.fillSendBlocks( blocks.data(), blocks.size() );
 
-	sendMessage( client, bufferedMessage );
+	if ( client.getShard()->poller->send( client.getFd(), { blocks.data(), count }, client.getSendOffset() ) )
+	{
+		client.setSendInFlight(true);
+		return (true);
+	}
+	return ( flushMessages( client ) );
 }
 
 
@@ -154,39 +189,12 @@ void	Response::sendPartialResponse( Client& client )
  * @param client Who will receive the notice.
  * @param notice Text to send.
  */
-void	Response::sendServerNotice( Client& client, const std::string& notice )
+void	Response::sendServerNotice( Client& client, std::string_view notice )
 {
-	std::string	templateMessage = getCommandTemplate( "NOTICE" );
+	FieldValues values = {};
 
-	if ( templateMessage.empty() )
-		return ;
-
-	size_t startPosition = templateMessage.find("NOTICE");
-
-	if ( startPosition == std::string::npos )
-		return ;
-
-	size_t endPosition = templateMessage.find("\r\n", startPosition);
-
-	if ( endPosition == std::string::npos )
-		return ;
-
-	templateMessage = ":<server> " + templateMessage.substr( startPosition, endPosition - startPosition ) + " <notice> \r\n";
-
-	string_map fields =
-	{
-		{ "server", _server },
-		{ "target", "*" },
-		{ "message", "***" },
-		{ "notice", notice }
-	};
-
-	if ( !client.getNickname().empty() )
-		fields["nick"] = client.getNickname();
-
-	std::string responseMessage = findAndReplacePlaceholders( templateMessage, fields );
-
-	sendMessage( client, responseMessage );
+	values[static_cast<size_t>(Field::SERVER)] = _server;
+	sendMessage( client, render( compiledTemplate<":<server> NOTICE * :*** <text> \r\n">, values, {{ Field::TEXT, notice }} ) );
 }
 
 /**
@@ -199,10 +207,10 @@ void	Response::sendServerNotice( Client& client, const std::string& notice )
  * @param ipAddress The ip address of the client or server which is disconnecting.
  * @param reason The explanation of the disconnection.
  */
-void	Response::sendServerError( Client& target, const std::string& ipAddress, const std::string& reason )
+void	Response::sendServerError( Client& target, std::string_view ipAddress, std::string_view reason )
 {
-	std::string responseMessage = "ERROR :Closing Link: " + ipAddress + " (" + reason + ")\r\n";
-	sendMessage(target, responseMessage);
+	sendMessage( target, render( compiledTemplate<"ERROR :Closing Link: <host> (<reason>)\r\n">, {},
+		{{ Field::HOST, ipAddress }, { Field::REASON, reason }} ) );
 }
 
 
@@ -216,8 +224,8 @@ void	Response::sendWelcome( Client& client )
 	Response::sendResponseCode(Response::RPL_WELCOME, client, {});
 	Response::sendResponseCode(Response::RPL_YOURHOST, client, {});
 	Response::sendResponseCode(Response::RPL_CREATED, client, {});
-	Response::sendResponseCode(Response::RPL_MYINFO, client, {{"channel modes", irc::CHANNEL_MODES}});
-	Response::sendResponseCode(Response::RPL_ISUPPORT, client, {{"param", _isupport}});
+	Response::sendResponseCode(Response::RPL_MYINFO, client, {{Field::CHANNEL_MODES, irc::CHANNEL_MODES}});
+	Response::sendResponseCode(Response::RPL_ISUPPORT, client, {{Field::PARAM, _isupport}});
 }
 
 
@@ -229,12 +237,10 @@ void	Response::sendWelcome( Client& client )
  * @param target Who should receive the message.
  * @param token The server getting pinged.
  */
-void	Response::sendPing( Client& target, const std::string& token )
+void	Response::sendPing( Client& target, std::string_view token )
 {
-	std::string pingToken = token.empty() ? _server : token;
-	std::string responseMessage = ":" + _server + " PING " + target.getNickname() + " :" + pingToken + "\r\n";
-
-	sendMessage( target, responseMessage );
+	sendMessage( target, render( compiledTemplate<":<server> PING <nick> :<param>\r\n">, {},
+		{{ Field::SERVER, _server }, { Field::NICK, target.getNickname() }, { Field::PARAM, token.empty() ? std::string_view( _server ) : token }} ) );
 }
 
 /**
@@ -243,12 +249,10 @@ void	Response::sendPing( Client& target, const std::string& token )
  * @param target Who should receive the message.
  * @param token The daemon getting ponged (usually the client who is the target).
  */
-void	Response::sendPong( Client& target, const std::string& token )
+void	Response::sendPong( Client& target, std::string_view token )
 {
-	std::string pongToken = token.empty() ? _server : token;
-	std::string responseMessage = ":" + _server + " PONG " + target.getNickname() + " :" + pongToken + "\r\n";
-
-	sendMessage( target, responseMessage );
+	sendMessage( target, render( compiledTemplate<":<server> PONG <nick> :<param>\r\n">, {},
+		{{ Field::SERVER, _server }, { Field::NICK, target.getNickname() }, { Field::PARAM, token.empty() ? std::string_view( _server ) : token }} ) );
 }
 
 
@@ -267,194 +271,182 @@ void		Response::setIsupport		( const std::string& message )	{ _isupport = messag
 /// Static helper functions
 
 /**
- * @brief Sends a composed message to client.
- * When message couldn't be sent, appends the message to the client send buffer.
+ * @brief Queues an already rendered block. The client only keeps a reference to it.
+ * A client of another shard gets the block through that shard's inbox.
  *
  * @param client The recipient of the message.
- * @param message the message to send to the recipient.
+ * @param message the shared message to send to the recipient.
+ * @param droppable Low priority channel chatter, which a slow consumer may lose.
  */
-void	Response::sendMessage( Client& client, const std::string& message )
+void	Response::sendMessage( Client& client, const MessageBlock& message, bool droppable )
 {
-	ssize_t bytes = send( client.getFd(), message.c_str(), message.length(), MSG_NOSIGNAL );
+	if ( !client.getActive() ) // Already closing, its last messages are queued
+		return ;
+	if ( Server::forwardMessage( client, message, droppable ) )
+		return ;
 
-	if ( bytes < 0 )
+	if ( client.appendToSendBuffer(message, droppable) )
 	{
-		if ( errno == EAGAIN || errno == EWOULDBLOCK )
+		if ( !client.getSendQueued() )
 		{
-			if ( client.getActive() && client.appendToSendBuffer(message) )
-			{
-				client.setPollout(true);
-				Server::setPolloutEvent(true);
-				if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
-					irc::log_event( "SEND", irc::LOG_DEBUG, "reattempting to send message");
-				return ;
-			}
+			client.setSendQueued(true);
+			Server::setSendEvent(client);
 		}
-		client.setActive(false);
-		Server::setDisconnectEvent(true);
-		if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
-			irc::log_event( "SEND", irc::LOG_FAIL, "client has disconnected");
 		return ;
 	}
-	else if ( bytes < static_cast<ssize_t>(message.length()) )
-	{
-		if ( client.getActive() && client.appendToSendBuffer(message.substr(bytes)) )
-		{
-			client.setPollout(true);
-			Server::setPolloutEvent(true);
-			return ;
-		}
 
-		Response::sendServerError( client, client.getIpAddress(), "protocol violation");
-
-		client.setActive(false);
-		Server::setDisconnectEvent(true);
-		if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
-			irc::log_event( "SEND", irc::LOG_FAIL, "dropping client connection");
-		return ;
-	}
+	client.setActive(false);
+	Server::setDisconnectEvent(client);
+	if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
+		irc::log_event( "SEND", irc::LOG_FAIL, "dropping client connection");
 }
 
-std::string	Response::findAndReplacePlaceholders( const std::string& template_string, const string_map& placeholders )
+/**
+ * @brief Writes a template into a new block in a single pass, sized up front so it never grows.
+ *
+ * @param format The compiled template.
+ * @param values Default value of every field.
+ * @param args Values given by the caller, they replace the defaults.
+ * @return The rendered line.
+ */
+MessageBlock	Response::render( const ResponseTemplate& format, const FieldValues& values, Args args )
 {
-	std::string result = template_string;
+	FieldValues	fields = values;
+	size_t		length = 0;
 
-	for ( const auto& [placeholder, value] : placeholders )
-	{
-		std::string tag = "<" + placeholder + ">";
+	for ( const Arg& arg : args )
+		fields[static_cast<size_t>(arg.field)] = arg.value;
 
-		for ( size_t pos = result.find( tag, 0 ); pos != std::string::npos; pos = result.find( tag, pos ) )
-		{
-			result.replace( pos, tag.length(), value );
-			pos += value.length();
-		}
-	}
-	return (result);
+	for ( const ResponseTemplate::Segment& segment : format )
+		length += segment.isField ? fields[static_cast<size_t>(segment.field)].length() : segment.literal.length();
+
+	auto line = std::make_shared<std::string>();
+
+	line->reserve( length );
+	for ( const ResponseTemplate::Segment& segment : format )
+		line->append( segment.isField ? fields[static_cast<size_t>(segment.field)] : segment.literal );
+	return ( line );
 }
 
 /**
  * @brief Selects the message template for a given command.
  *
- * @param command The command ran in string form.
- * @return Template message if match is found, otherwise empty string.
+ * @param command The command ran.
+ * @param withReason Whether a reason was given, PART drops its trailing message and QUIT uses a default one without it.
+ * @return Template message if match is found, otherwise nullptr.
  */
-std::string	Response::getCommandTemplate( const std::string& command )
+const ResponseTemplate*	Response::getCommandTemplate( CommandType command, bool withReason )
 {
-	static const string_map validCommands =
+	switch ( command )
 	{
-		{"PRIVMSG", ":<nick>!<user>@<host> PRIVMSG <target> :<message>\r\n"},
-		{"NOTICE", ":<nick>!<user>@<host> NOTICE <target> :<message>\r\n"},
-		{"JOIN", ":<nick>!<user>@<host> JOIN <channel>\r\n"},
-		{"PART", ":<nick>!<user>@<host> PART <channel> :<reason>\r\n"},
-		{"QUIT", ":<nick>!<user>@<host> QUIT :<reason>\r\n"},
-		{"NICK", ":<nick>!<user>@<host> NICK :<new nick>\r\n"},
-		{"KICK", ":<nick>!<user>@<host> KICK <channel> <target> :<reason>\r\n"},
-		{"TOPIC", ":<nick>!<user>@<host> TOPIC <channel> :<topic>\r\n"},
-		{"MODE", ":<nick>!<user>@<host> MODE <channel> <flags> <target>\r\n"},
-		{"INVITE", ":<nick>!<user>@<host> INVITE <target> :<channel>\r\n"}
-	};
-
-	auto it = validCommands.find(command);
-	if ( it != validCommands.end() )
-		return ( it->second );
-	return ("");
+		case CommandType::PRIVMSG:	return &compiledTemplate<":<source> PRIVMSG <target> :<message>\r\n">;
+		case CommandType::NOTICE:	return &compiledTemplate<":<source> NOTICE <target> :<message>\r\n">;
+		case CommandType::JOIN:		return &compiledTemplate<":<source> JOIN <channel>\r\n">;
+		case CommandType::PART:
+			if ( withReason )
+				return &compiledTemplate<":<source> PART <channel> :<reason>\r\n">;
+			return &compiledTemplate<":<source> PART <channel>\r\n">;
+		case CommandType::QUIT:
+			if ( withReason )
+				return &compiledTemplate<":<source> QUIT :<reason>\r\n">;
+			return &compiledTemplate<":<source> QUIT :Client Quit\r\n">;
+		case CommandType::NICK:		return &compiledTemplate<":<source> NICK :<new nick>\r\n">;
+		case CommandType::KICK:		return &compiledTemplate<":<source> KICK <channel> <target> :<reason>\r\n">;
+		case CommandType::TOPIC:	return &compiledTemplate<":<source> TOPIC <channel> :<topic>\r\n">;
+		case CommandType::MODE:		return &compiledTemplate<":<source> MODE <channel> <flags> <target>\r\n">;
+		case CommandType::INVITE:	return &compiledTemplate<":<source> INVITE <target> :<channel>\r\n">;
+		default:
+			return nullptr;
+	}
 }
 
 /**
  * @brief Formats the response code. For example '1' becomes '001'
  *
  * @param code The response code to send.
- * @return The response code in string form.
+ * @return The three digits of the response code.
  */
-std::string	Response::formatCode( int code )
+std::array<char, 3>	Response::formatCode( int code )
 {
-	std::string formatted;
-
-	if ( code < 100 )
-		formatted += '0';
-	if ( code < 10 )
-		formatted += '0';
-	formatted += std::to_string(code);
-
-	return (formatted);
+	return { static_cast<char>( '0' + code / 100 % 10 ), static_cast<char>( '0' + code / 10 % 10 ), static_cast<char>( '0' + code % 10 ) };
 }
 
 /**
  * @brief Selects the message template for a given response code.
  *
  * @param code The response code to use to fetch a message template.
- * @return If match found then associated message, otherwise empty string.
+ * @return If match found then the compiled template, otherwise nullptr.
  */
-std::string	Response::getResponseTemplate( int code )
+const ResponseTemplate*	Response::getResponseTemplate( int code )
 {
 	switch ( code )
 	{
 		/// Connection registration
-		case RPL_WELCOME:			return ":<server> <code> <nick> :Welcome to the Internet Relay Network <nick>\r\n";
-		case RPL_YOURHOST:			return ":<server> <code> <nick> :Your host is <server>, running version <version>\r\n";
-		case RPL_CREATED:			return ":<server> <code> <nick> :This server was created <date>\r\n";
-		case RPL_MYINFO:			return ":<server> <code> <nick> <server> <version> <user modes> <channel modes>\r\n";
-		case RPL_ISUPPORT:			return ":<server> <code> <nick> <param> :are supported by this server\r\n";
-		case ERR_NONICKNAMEGIVEN:	return ":<server> <code> <nick> :No nickname given\r\n";
-		case ERR_ERRONEUSNICKNAME:	return ":<server> <code> <nick> <new nick> :Erroneous nickname\r\n";
-		case ERR_NICKNAMEINUSE:		return ":<server> <code> <nick> <new nick> :Nickname is already in use\r\n";
-		case ERR_NOTREGISTERED:		return ":<server> <code> <nick> :You have not registered\r\n";
-		case ERR_NEEDMOREPARAMS:	return ":<server> <code> <nick> <command> :Not enough parameters\r\n";
-		case ERR_ALREADYREGISTERED:	return ":<server> <code> <nick> :You may not reregister\r\n";
-		case ERR_PASSWDMISMATCH:	return ":<server> <code> <nick> :Password incorrect\r\n";
-		case ERR_TOOMANYCHANNELS:	return ":<server> <code> <nick> <channel> :You have joined too many channels\r\n";
+		case RPL_WELCOME:			return &compiledTemplate<":<server> <code> <nick> :Welcome to the Internet Relay Network <nick>\r\n">;
+		case RPL_YOURHOST:			return &compiledTemplate<":<server> <code> <nick> :Your host is <server>, running version <version>\r\n">;
+		case RPL_CREATED:			return &compiledTemplate<":<server> <code> <nick> :This server was created <date>\r\n">;
+		case RPL_MYINFO:			return &compiledTemplate<":<server> <code> <nick> <server> <version> <user modes> <channel modes>\r\n">;
+		case RPL_ISUPPORT:			return &compiledTemplate<":<server> <code> <nick> <param> :are supported by this server\r\n">;
+		case ERR_NONICKNAMEGIVEN:	return &compiledTemplate<":<server> <code> <nick> :No nickname given\r\n">;
+		case ERR_ERRONEUSNICKNAME:	return &compiledTemplate<":<server> <code> <nick> <new nick> :Erroneous nickname\r\n">;
+		case ERR_NICKNAMEINUSE:		return &compiledTemplate<":<server> <code> <nick> <new nick> :Nickname is already in use\r\n">;
+		case ERR_NOTREGISTERED:		return &compiledTemplate<":<server> <code> <nick> :You have not registered\r\n">;
+		case ERR_NEEDMOREPARAMS:	return &compiledTemplate<":<server> <code> <nick> <command> :Not enough parameters\r\n">;
+		case ERR_ALREADYREGISTERED:	return &compiledTemplate<":<server> <code> <nick> :You may not reregister\r\n">;
+		case ERR_PASSWDMISMATCH:	return &compiledTemplate<":<server> <code> <nick> :Password incorrect\r\n">;
+		case ERR_TOOMANYCHANNELS:	return &compiledTemplate<":<server> <code> <nick> <channel> :You have joined too many channels\r\n">;
 
 
 		/// Channel operations
-		case RPL_LIST:				return ":<server> <code> <nick> <channel> <users> :<topic>\r\n";
-		case RPL_LISTEND:			return ":<server> <code> <nick> :End of /LIST\r\n";
-		case RPL_NOTOPIC:			return ":<server> <code> <nick> <channel> :No topic is set\r\n";
-		case RPL_TOPIC:				return ":<server> <code> <nick> <channel> :<topic>\r\n";
-		case RPL_NAMREPLY:			return ":<server> <code> <nick> <symbol> <channel> :<names>\r\n";
-		case RPL_ENDOFNAMES:		return ":<server> <code> <nick> <channel> :End of /NAMES\r\n";
-
-		case RPL_INVITING:			return ":<server> <code> <nick> <target> <channel>\r\n";
-		case RPL_CHANNELMODEIS:		return ":<server> <code> <nick> <channel> <mode> <mode params>\r\n";
-		case ERR_UNKNOWNMODE:		return ":<server> <code> <nick> <mode> :is unknown mode char to me\r\n";
-
-		case ERR_NOSUCHCHANNEL:		return ":<server> <code> <nick> <channel> :No such channel\r\n";
-		case ERR_CHANNELISFULL:		return ":<server> <code> <nick> <channel> :Channel is full\r\n";
-		case ERR_INVITEONLYCHAN:	return ":<server> <code> <nick> <channel> :Invite only channel\r\n";
-		case ERR_BANNEDFROMCHAN:	return ":<server> <code> <nick> <channel> :Banned from channel\r\n";
-		case ERR_BADCHANNELKEY:		return ":<server> <code> <nick> <channel> :Bad channel key\r\n";
-
-		case ERR_USERNOTINCHANNEL:	return ":<server> <code> <nick> <target> <channel> :User not in channel\r\n";
-		case ERR_NOTONCHANNEL:		return ":<server> <code> <nick> <channel> :You're not on that channel\r\n";
-		case ERR_USERONCHANNEL:		return ":<server> <code> <nick> <target> <channel> :User already on channel\r\n";
+		case RPL_LIST:				return &compiledTemplate<":<server> <code> <nick> <channel> <users> :<topic>\r\n">;
+		case RPL_LISTEND:			return &compiledTemplate<":<server> <code> <nick> :End of /LIST\r\n">;
+		case RPL_NOTOPIC:			return &compiledTemplate<":<server> <code> <nick> <channel> :No topic is set\r\n">;
+		case RPL_TOPIC:				return &compiledTemplate<":<server> <code> <nick> <channel> :<topic>\r\n">;
+		case RPL_NAMREPLY:			return &compiledTemplate<":<server> <code> <nick> <symbol> <channel> :<names>\r\n">;
+		case RPL_ENDOFNAMES:		return &compiledTemplate<":<server> <code> <nick> <channel> :End of /NAMES\r\n">;
+
+		case RPL_INVITING:			return &compiledTemplate<":<server> <code> <nick> <target> <channel>\r\n">;
+		case RPL_CHANNELMODEIS:		return &compiledTemplate<":<server> <code> <nick> <channel> <mode> <mode params>\r\n">;
+		case ERR_UNKNOWNMODE:		return &compiledTemplate<":<server> <code> <nick> <mode> :is unknown mode char to me\r\n">;
+
+		case ERR_NOSUCHCHANNEL:		return &compiledTemplate<":<server> <code> <nick> <channel> :No such channel\r\n">;
+		case ERR_CHANNELISFULL:		return &compiledTemplate<":<server> <code> <nick> <channel> :Channel is full\r\n">;
+		case ERR_INVITEONLYCHAN:	return &compiledTemplate<":<server> <code> <nick> <channel> :Invite only channel\r\n">;
+		case ERR_BANNEDFROMCHAN:	return &compiledTemplate<":<server> <code> <nick> <channel> :Banned from channel\r\n">;
+		case ERR_BADCHANNELKEY:		return &compiledTemplate<":<server> <code> <nick> <channel> :Bad channel key\r\n">;
+
+		case ERR_USERNOTINCHANNEL:	return &compiledTemplate<":<server> <code> <nick> <target> <channel> :User not in channel\r\n">;
+		case ERR_NOTONCHANNEL:		return &compiledTemplate<":<server> <code> <nick> <channel> :You're not on that channel\r\n">;
+		case ERR_USERONCHANNEL:		return &compiledTemplate<":<server> <code> <nick> <target> <channel> :User already on channel\r\n">;
 
 		/// Channel operators
-		case ERR_CHANOPRIVSNEEDED:	return ":<server> <code> <nick> <channel> :You're not channel operator\r\n";
+		case ERR_CHANOPRIVSNEEDED:	return &compiledTemplate<":<server> <code> <nick> <channel> :You're not channel operator\r\n">;
 
 		/// Message handling
-		case ERR_NOSUCHNICK:		return ":<server> <code> <nick> :No such nickname\r\n";
-		case ERR_CANNOTSENDTOCHAN:	return ":<server> <code> <nick> :Cannot send to channel\r\n";
-		case ERR_NOTEXTTOSEND:		return ":<server> <code> <nick> :No text to send\r\n";
-		case ERR_INPUTTOOLONG:		return ":<server> <code> <nick> :Input line was too long\r\n";
-		case ERR_UNKNOWNCOMMAND:	return ":<server> <code> <nick> <command> :Unknown command\r\n";
+		case ERR_NOSUCHNICK:		return &compiledTemplate<":<server> <code> <nick> :No such nickname\r\n">;
+		case ERR_CANNOTSENDTOCHAN:	return &compiledTemplate<":<server> <code> <nick> :Cannot send to channel\r\n">;
+		case ERR_NOTEXTTOSEND:		return &compiledTemplate<":<server> <code> <nick> :No text to send\r\n">;
+		case ERR_INPUTTOOLONG:		return &compiledTemplate<":<server> <code> <nick> :Input line was too long\r\n">;
+		case ERR_UNKNOWNCOMMAND:	return &compiledTemplate<":<server> <code> <nick> <command> :Unknown command\r\n">;
 
-		case RPL_WHOISUSER:			return ":<server> <code> <nick> <target> <user> <host> * :<real name>\r\n";
-		case RPL_WHOISSERVER:		return ":<server> <code> <nick> <target> <server> :<server info>\r\n";
-		case RPL_WHOISOPERATOR:		return ":<server> <code> <nick> <target> :is an IRC operator\r\n";
-		case RPL_ENDOFWHOIS:		return ":<server> <code> <nick> <target> :End of /WHOIS list\r\n";
+		case RPL_WHOISUSER:			return &compiledTemplate<":<server> <code> <nick> <target> <user> <host> * :<real name>\r\n">;
+		case RPL_WHOISSERVER:		return &compiledTemplate<":<server> <code> <nick> <target> <server> :<server info>\r\n">;
+		case RPL_WHOISOPERATOR:		return &compiledTemplate<":<server> <code> <nick> <target> :is an IRC operator\r\n">;
+		case RPL_ENDOFWHOIS:		return &compiledTemplate<":<server> <code> <nick> <target> :End of /WHOIS list\r\n">;
 
 		/// Message of the day
-		case RPL_MOTDSTART:			return "<server> <code> <nick> :- <server> Message of the day -\r\n";
-		case RPL_MOTD:				return "<server> <code> <nick> :- <text> -\r\n";
-		case RPL_ENDOFMOTD:			return "<server> <code> <nick> :End of /MOTD command\r\n";
-		case ERR_NOMOTD:			return "<server> <code> <nick> :MOTD File is missing\r\n";
+		case RPL_MOTDSTART:			return &compiledTemplate<"<server> <code> <nick> :- <server> Message of the day -\r\n">;
+		case RPL_MOTD:				return &compiledTemplate<"<server> <code> <nick> :- <text> -\r\n">;
+		case RPL_ENDOFMOTD:			return &compiledTemplate<"<server> <code> <nick> :End of /MOTD command\r\n">;
+		case ERR_NOMOTD:			return &compiledTemplate<"<server> <code> <nick> :MOTD File is missing\r\n">;
 
 
 		/// Disabled features
-		case ERR_SUMMONDISABLED:	return "<server> <code> <nick> :SUMMON has been disabled\r\n";
-		case ERR_USERSDISABLED:		return "<server> <code> <nick> :USERS has been disabled\r\n";
+		case ERR_SUMMONDISABLED:	return &compiledTemplate<"<server> <code> <nick> :SUMMON has been disabled\r\n">;
+		case ERR_USERSDISABLED:		return &compiledTemplate<"<server> <code> <nick> :USERS has been disabled\r\n">;
 
 
 		default:
-			return "";
+			return nullptr;
 	}
 }
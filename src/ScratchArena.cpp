@@ -0,0 +1,40 @@
+#include "ScratchArena.hpp"
+
+thread_local ScratchArena*	ScratchArena::_current = nullptr;
+
+/// Constructors and destructors
+
+ScratchArena::ScratchArena() :
+	_resource( _buffer.data(), _buffer.size(), std::pmr::new_delete_resource() )
+{}
+
+ScratchArena::~ScratchArena()
+{
+	if ( _current == this )
+		_current = nullptr;
+}
+
+
+/// Arena lifetime
+
+/**
+ * @brief Makes this the arena irc::scratch() hands out on the calling thread.
+ */
+void	ScratchArena::makeCurrent() noexcept
+{
+	_current = this;
+}
+
+/**
+ * @brief Drops everything allocated since the last release. The fixed buffer is reused,
+ * heap blocks taken by an oversized command or tick are returned.
+ */
+void	ScratchArena::release() noexcept
+{
+	_resource.release();
+}
+
+std::pmr::memory_resource*	ScratchArena::current() noexcept
+{
+	return ( _current ? &_current->_resource : std::pmr::get_default_resource() );
+}
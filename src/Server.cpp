@@ -7,12 +7,15 @@
 #include "Response.hpp"
 #include "Command.hpp"
 #include "Channels.hpp"
+#include "ByteScan.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <array>
 
 /// Static member variables
 
-bool	Server::_terminate = false;
-bool	Server::_disconnectEvent = false;
-bool	Server::_polloutEvent = false;
+std::atomic<bool>		Server::_terminate = false;
+thread_local Shard*		Server::_localShard = nullptr;
 
 
 /// Constructors and destructors
@@ -20,7 +23,10 @@ bool	Server::_polloutEvent = false;
 Server::Server( const std::string port, const std::string password ) :
 	_port( std::stoi(port) ),
 	_password( password ),
-	_serverSocket( -1 ),
+	_objectPool( std::pmr::pool_options{ 0, irc::OBJECT_POOL_LARGEST_BLOCK } ),
+	_clients( &_objectPool ),
+	_nicknames( &_objectPool ),
+	_channels( &_objectPool ),
 	_serverStartTime( Logger::timestamp() ),
 	_serverHostname( fetchHostname() ),
 	_serverVersion( irc::SERVER_VERSION ),
@@ -41,16 +47,14 @@ Server::Server( const std::string port, const std::string password ) :
 
 Server::~Server()
 {
-	for ( const auto& fd : _fds )
-	{
-		if ( fd.fd >= 0 )
-			close( fd.fd );
-	}
+	for ( const Client& client : _clients )
+		close( client.getFd() );
 
-	if ( !_fds.empty() )
-		_fds.clear();
 	if ( !_clients.empty() )
 		_clients.clear();
+	_nicknames.clear();
+	if ( !_shards.empty() )
+		_shards.clear();
 
 	signalSetup( false );
 }
@@ -64,102 +68,227 @@ const std::string&	Server::getServerVersion	() const { return (_serverVersion);
 
 /// Setters
 
-void	Server::setDisconnectEvent	( bool event ) { _disconnectEvent = event; }
-void	Server::setPolloutEvent		( bool event ) { _polloutEvent = event; }
+/**
+ * @brief Queues the client for disconnection on the next tick. Only the shard owning the client
+ * marks it, every path doing so runs on behalf of the client itself.
+ */
+void	Server::setDisconnectEvent( Client& client )
+{
+	Shard* shard = client.getShard();
+
+	if ( !shard )
+		return ;
+	shard->pendingDisconnects.push_back( client.getFd() );
+}
+
+/**
+ * @brief Queues the client for a flush at the end of the owning shard's loop tick.
+ * Lines for clients of other shards are forwarded first, so this only runs on the owner.
+ */
+void	Server::setSendEvent( Client& client )
+{
+	Shard* shard = client.getShard();
+
+	if ( !shard )
+		return ;
+	shard->pendingSends.push_back( client.getFd() );
+}
+
+/**
+ * @brief Hands the line to the shard owning the client when it is not the calling shard.
+ * Outside of the event loops, during shutdown, every client is written directly.
+ *
+ * @return true if the line was forwarded, false if the caller owns the client.
+ */
+bool	Server::forwardMessage( Client& client, const MessageBlock& message, bool droppable )
+{
+	Shard* shard = client.getShard();
+
+	if ( !shard || !_localShard || shard == _localShard )
+		return ( false );
+	shard->forward( client.getHandle(), message, droppable );
+	return ( true );
+}
 
 
 /// Member functions
 
+/**
+ * @brief Creates the event loop shards. Every shard gets its own listener bound to the same port,
+ * the kernel then spreads new connections across them through SO_REUSEPORT.
+ */
 void	Server::serverSetup()
 {
-	_serverSocket = socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP );
-	if ( _serverSocket < 0 )
+	unsigned	shardCount	= irc::REACTOR_THREADS;
+	const char*	override	= std::getenv( irc::REACTOR_THREADS_ENV );
+
+	if ( override )
+		shardCount = static_cast<unsigned>( std::strtoul( override, nullptr, 10 ) );
+	if ( shardCount == 0 )
+		shardCount = std::max( 1U, std::thread::hardware_concurrency() );
+
+	for ( unsigned idx = 0; idx < shardCount; ++idx )
+	{
+		_shards.push_back( std::make_unique<Shard>( idx ) );
+		createListener( *_shards.back() );
+	}
+
+	irc::log_event("SERVER", irc::LOG_SUCCESS, "running on port " + std::to_string(_port) + " using "
+		+ _shards.front()->poller->name() + " with " + std::to_string(shardCount) + " event loop thread(s)");
+	irc::log_event("SERVER", irc::LOG_DEBUG, std::string("scanning input with the ") + irc::byteScanKernel() + " kernel");
+}
+
+void	Server::createListener( Shard& shard )
+{
+	shard.listener = socket( AF_INET, SOCK_STREAM | SOCK_NONBLOCK, IPPROTO_TCP );
+	if ( shard.listener < 0 )
 		throw ( std::runtime_error("Error: failed to create server socket.") );
 
 	int option = 1;
-	if ( setsockopt( _serverSocket, SOL_SOCKET, SO_REUSEADDR, &option, sizeof( option ) ) < 0 )
+	if ( setsockopt( shard.listener, SOL_SOCKET, SO_REUSEADDR, &option, sizeof( option ) ) < 0 )
 		throw ( std::runtime_error("Error: failed to set socket options.") );
 
-	if ( setsockopt( _serverSocket, SOL_SOCKET, SO_REUSEPORT, &option, sizeof( option ) ) < 0 )
+	if ( setsockopt( shard.listener, SOL_SOCKET, SO_REUSEPORT, &option, sizeof( option ) ) < 0 )
 		throw ( std::runtime_error("Error: failed to set socket options.") );
 
-	if ( bind( _serverSocket, &_serverAddress, sizeof( _serverAddress )) < 0 )
+	if ( bind( shard.listener, &_serverAddress, sizeof( _serverAddress )) < 0 )
 		throw ( std::runtime_error("Error: failed to bind server socket.") );
 
-	if ( listen( _serverSocket, irc::MAX_CONNECTION_REQUESTS ) < 0 )
+	if ( listen( shard.listener, irc::MAX_CONNECTION_REQUESTS ) < 0 )
 		throw ( std::runtime_error("Error: failed to listen on port: " + std::to_string(_port)) );
 
-	pollfd	serverPoll;
+	// The listener stays level-triggered so a connection left in the backlog is reported again
+	if ( !shard.poller->add( shard.listener, POLLIN, nullptr, false ) )
+		throw ( std::runtime_error("Error: failed to register server socket.") );
+}
 
-	serverPoll.fd = _serverSocket;
-	serverPoll.events = POLLIN;
-	serverPoll.revents = 0;
+/**
+ * @brief Runs every shard. The calling thread runs the first shard and is the only one
+ * receiving SIGINT and SIGQUIT, the other shards are woken up when it shuts down.
+ */
+void	Server::serverLoop()
+{
+	sigset_t	signals;
+	sigset_t	previous;
 
-	_fds.insert( _fds.cbegin(), serverPoll );
+	sigemptyset( &signals );
+	sigaddset( &signals, SIGINT );
+	sigaddset( &signals, SIGQUIT );
 
-	_lastTimeoutCheck = std::chrono::steady_clock::now();
+	// Threads inherit the signal mask, block the signals only while spawning them
+	pthread_sigmask( SIG_BLOCK, &signals, &previous );
+	for ( size_t idx = 1; idx < _shards.size(); ++idx )
+	{
+		Shard& shard = *_shards[idx];
+		shard.thread = std::thread( [this, &shard]() { shardLoop( shard ); } );
+	}
+	pthread_sigmask( SIG_SETMASK, &previous, nullptr );
+
+	shardLoop( *_shards.front() );
+
+	bool signaled = _terminate;
+
+	_terminate = true;
+	for ( auto& shard : _shards )
+	{
+		shard->wake();
+		if ( shard->thread.joinable() )
+			shard->thread.join();
+	}
 
-	irc::log_event("SERVER", irc::LOG_SUCCESS, "running on port " + std::to_string(_port));
+	// Every event loop has stopped, the clients are written from this thread alone
+	if ( signaled )
+		broadcastShutdown( "signaled" );
 }
 
-void	Server::serverLoop()
+void	Server::shardLoop( Shard& shard )
 {
+	_localShard = &shard;
+	shard.scratch.makeCurrent();
+
 	while ( !_terminate )
 	{
-		checkTimeouts(); // Checks if any clients were timed out
+		++shard.tick;
+		shard.scratch.release(); // Nothing built during the previous tick is still referenced
 
-		if ( _disconnectEvent ) // Disconnects any timed out clients
+		processTimers( shard ); // Times out and pings the clients which came due
+
+		if ( !shard.pendingDisconnects.empty() ) // Disconnects any timed out clients
 		{
-			disconnectClients();
+			std::unique_lock<std::shared_mutex> lock( _stateMutex );
+			disconnectClients( shard );
 			continue ;
 		}
 
-		int pollResult = poll( _fds.data(), _fds.size(), irc::TIMEOUT_INTERVAL_MILLIS );
-		if ( pollResult  <= 0 )
+		if ( shard.takeInbox() ) // Queues the lines other shards forwarded to our clients
+			deliverForwarded( shard );
+
+		if ( !shard.pendingReads.empty() ) // Runs the messages left over by the budget of the last tick
+			resumeDeferredReads( shard );
+
+		if ( !shard.pendingSends.empty() ) // Writes the replies queued during the last tick
 		{
-			if ( errno == EINTR ) // signal was caught during poll
-			{
-				broadcastShutdown( "signaled" );
-				break ;
-			}
-			continue ;
+			std::shared_lock<std::shared_mutex> lock( _stateMutex );
+			flushClients( shard );
 		}
 
-		std::vector<pollfd>	newClients;
+		// Clients with deferred messages are picked up again on the next tick without blocking
+		int timeout		= shard.pendingReads.empty()
+			? shard.timers.nextTimeout( std::chrono::steady_clock::now(), irc::TIMEOUT_INTERVAL_MILLIS ) : 0;
+		int pollResult	= shard.poller->wait( shard.readyEvents, timeout );
+		if ( pollResult  <= 0 ) // A shutdown signal sets _terminate, any other interruption just waits again
+			continue ;
 
-		for ( auto& fd : _fds )
+		for ( const auto& event : shard.readyEvents )
 		{
-			if ( fd.revents & POLLIN )
+			if ( event.fd == shard.wakeFd ) // Another shard raised an event flag
 			{
-				if ( fd.fd == _serverSocket ) // Accept new connection
-				{
-					if ( !acceptClientConnection( newClients ) )
-						continue ;
-				}
-				else // Client is sending a new message
+				shard.clearWake();
+				continue ;
+			}
+			if ( event.fd == shard.listener ) // Accept new connection
+			{
+				if ( event.completed )
+					adoptClientConnection( shard, event.result );
+				else if ( event.events & POLLIN )
+					acceptClientConnection( shard );
+				continue ;
+			}
+
+			Client& client = *static_cast<Client*>( event.data );
+
+			if ( event.events & POLLIN ) // Client is sending a new message
+			{
+				bool alive;
+				if ( event.completed )
 				{
-					if ( !receiveClientMessage( fd.fd ) )
-						continue ;
+					alive = receiveCompletedMessage( shard, client, event.buffer, event.result );
+					if ( alive )
+						updateClientEvents( shard, client );
 				}
+				else
+					alive = receiveClientMessage( shard, client );
+				if ( !alive )
+					continue ;
 			}
-			else if ( fd.revents & POLLOUT ) // Server is ready to send message to client
+			else if ( event.events & ( POLLERR | POLLHUP | POLLNVAL ) ) // Remove client on error or hangup
 			{
-				Response::sendPartialResponse( _clients[fd.fd] );
-				if ( _clients[fd.fd].getPollout() == false )
-					fd.events &= ~POLLOUT;
+				client.setActive(false);
+				setDisconnectEvent( client );
+				continue ;
 			}
-			else if ( fd.revents & ( POLLERR | POLLHUP | POLLNVAL ) ) // Remove client on error or hangup
+
+			// Handled alongside POLLIN, as an edge-triggered backend will not report it again
+			if ( event.events & POLLOUT ) // Server is ready to send message to client
 			{
-				_clients[fd.fd].setActive(false);
-				_disconnectEvent = true;
+				if ( event.completed )
+					completeClientSend( shard, client, event.result );
+				else if ( Response::flushMessages( client ) )
+					updateClientEvents( shard, client );
 			}
 		}
-
-		if ( !newClients.empty() )
-			_fds.insert( _fds.end(), newClients.begin(), newClients.end() );
-		if ( _polloutEvent )
-			setClientsToPollout();
 	}
+	_localShard = nullptr; // Whatever runs on this thread next writes clients directly
 }
 
 
@@ -212,153 +341,300 @@ std::string	Server::fetchHostname()
 /// Client handling
 
 /**
- * @brief Acccepts a new client connection and stores it if successful.
+ * @brief Drains the listener backlog, accepting up to irc::ACCEPT_BATCH_LIMIT connections in one pass.
+ * accept4 creates the sockets non-blocking and close-on-exec without extra system calls.
+ * The state lock is taken once for the whole batch. Connections left over the budget stay
+ * in the backlog and are reported again by the level-triggered listener on the next tick.
  *
- * @param[in] new_clients the temporary vector where to store new client data
+ * @return Number of connections accepted.
+ */
+size_t	Server::acceptClientConnection( Shard& shard )
+{
+	std::array<std::pair<int, sockaddr>, irc::ACCEPT_BATCH_LIMIT>	accepted;
+	size_t															count = 0;
+
+	while ( count < accepted.size() )
+	{
+		sockaddr	clientAddress = {};
+		socklen_t	clientAddrLen = sizeof( clientAddress );
+
+		int	newClientSocket = accept4( shard.listener, &clientAddress, &clientAddrLen, SOCK_NONBLOCK | SOCK_CLOEXEC );
+		if ( newClientSocket < 0 )
+		{
+			if ( errno == EINTR || errno == ECONNABORTED )
+				continue ;
+			if ( errno != EAGAIN && errno != EWOULDBLOCK )
+				irc::log_event("CONNECTION", irc::LOG_FAIL, "accept failed");
+			break ;
+		}
+		accepted[count++] = { newClientSocket, clientAddress };
+	}
+
+	if ( count == 0 )
+		return ( 0 );
+
+	std::unique_lock<std::shared_mutex> lock( _stateMutex );
+
+	for ( size_t idx = 0; idx < count; ++idx )
+		registerClient( shard, accepted[idx].first, accepted[idx].second );
+
+	if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
+		irc::log_event("CONNECTION", irc::LOG_DEBUG, "accepted " + std::to_string(count) + " connection(s) in one pass");
+
+	return ( count );
+}
+
+/**
+ * @brief Stores a connection which the event backend already accepted.
+ * The socket arrives non-blocking, only the peer address has to be looked up.
+ *
+ * @param file_descriptor The accepted socket, or -errno if the accept failed.
  * @return true on success, otherwise false
  */
-bool	Server::acceptClientConnection( std::vector<pollfd>& new_clients )
+bool	Server::adoptClientConnection( Shard& shard, int file_descriptor )
 {
-	/**
-	 * 1. Accept the connection
-	 * 2. Create pollfd from the associated client socket
-	 * 3. Set events to POLLIN
-	 * 4. Create new Client class from the socket and store it in map
-	 * 5. Store pollfd in newClients
-	 * 6. Log the event
-	 */
-	Client		newClient;
 	sockaddr	clientAddress = {};
 	socklen_t	clientAddrLen = sizeof( clientAddress );
 
-	int	newClientSocket = accept( _serverSocket, &clientAddress, &clientAddrLen );
-	if ( newClientSocket < 0 )
+	if ( file_descriptor < 0 )
 	{
 		irc::log_event("CONNECTION", irc::LOG_FAIL, "accept failed");
-		return ( false ) ;
+		return ( false );
 	}
 
-	newClient.setClientFd( newClientSocket );
-	newClient.setClientAddress( clientAddress );
-	newClient.updateConnectionTime();
-	newClient.updateLastActivity();
-	newClient.updateLastPing();
+	getpeername( file_descriptor, &clientAddress, &clientAddrLen );
 
-	Server::fetchClientIp( newClient );
+	std::unique_lock<std::shared_mutex> lock( _stateMutex );
 
-	pollfd	clientPoll;
-	clientPoll.fd = newClientSocket;
-	clientPoll.events = POLLIN;
-	clientPoll.revents = 0;
-	new_clients.push_back(clientPoll);
+	return ( registerClient( shard, file_descriptor, clientAddress ) );
+}
 
-	_clients[newClientSocket] = newClient;
+/**
+ * @brief Creates the Client for an accepted socket and registers the socket with the event backend
+ * of the shard which accepted it. The caller must hold the state lock.
+ *
+ * @param shard The shard which will own the client.
+ * @param file_descriptor The non-blocking client socket.
+ * @param address The peer address of the client.
+ * @return true on success, otherwise false
+ */
+bool	Server::registerClient( Shard& shard, int file_descriptor, const sockaddr& address )
+{
+	/**
+	 * 1. Create new Client class from the socket and store it in map
+	 * 2. Register the socket for POLLIN with the stored client as event data
+	 * 3. Log the event
+	 */
+	Client&	storedClient = _clients.emplace( file_descriptor );
+
+	storedClient.setClientFd( file_descriptor );
+	storedClient.setHandle( _clients.handle( file_descriptor ) );
+	storedClient.setShard( &shard );
+	storedClient.setClientAddress( address );
+	storedClient.updateConnectionTime();
+	storedClient.updateLastActivity();
+	storedClient.updateLastPing();
+
+	Server::fetchClientIp( storedClient );
+
+	scheduleClientTimer( shard, storedClient, storedClient.getConnectionTime() + std::chrono::seconds( irc::CLIENT_REGISTRATION_TIMEOUT ) );
+
+	if ( !shard.poller->add( file_descriptor, POLLIN, &storedClient ) )
+	{
+		irc::log_event("CONNECTION", irc::LOG_FAIL, "failed to register client socket");
+		_clients.erase( file_descriptor );
+		close( file_descriptor );
+		return ( false );
+	}
 
-	irc::log_event("CONNECTION", irc::LOG_SUCCESS, "client connected from " + newClient.getIpAddress());
+	irc::log_event("CONNECTION", irc::LOG_SUCCESS, irc::concat("client connected from ", storedClient.getIpAddress()));
 
 	return ( true );
 }
 
 /**
- * @brief Disconnects all clients marked as inactive.
- * Closes the associated file descriptor and removes the associated pollfd.
+ * @brief Disconnects all clients of the shard marked as inactive.
+ * Closes the associated file descriptor and unregisters it from the event backend.
  *
- * NOTE: This will not alert all channel members about the disconnect
+ * Cleanup only visits the client's own channels and invites. Members of channels the client
+ * is still in are sent a QUIT with the client's quit reason, channels left empty are removed.
  */
-void	Server::disconnectClients()
+void	Server::disconnectClients( Shard& shard )
 {
 	std::vector<int> clientsToRemove;
 
-	for ( const auto& [fd, client] : _clients )
-	{
-		if ( client.getActive() == false )
-			clientsToRemove.push_back( client.getFd() );
-	}
+	clientsToRemove.swap( shard.pendingDisconnects );
 
 	for ( int fd : clientsToRemove )
 	{
-		irc::log_event("DISCONNECT", irc::LOG_INFO, _clients[fd].getNickname() + "@" + _clients[fd].getIpAddress());
+		// The same client may have been queued more than once, or the fd already reused
+		Client* client = _clients.find( fd );
+		if ( !client || client->getShard() != &shard || client->getActive() )
+			continue ;
 
-		close( fd );
-		_clients.erase( fd );
+		irc::log_event("DISCONNECT", irc::LOG_INFO, irc::concat(client->getNickname(), "@", client->getIpAddress()));
 
-		for ( auto it = _fds.begin(); it != _fds.end(); ++it )
+		if ( !client->getChannels().empty() )
+			_commandHandler.broadcastQuit( *client, client->getQuitReason() );
+		for ( ChannelId channelId : client->getInvites() )
 		{
-			if ( it->fd == fd )
-			{
-				_fds.erase(it);
-				break ;
-			}
+			if ( Channel* channel = findChannel( channelId ) )
+				channel->removeInvite( client->getHandle() );
 		}
 
-		for ( auto it = _channels.begin(); it != _channels.end(); )
-		{
-			if ( it->isMember(fd) )
-				it->removeMember(fd);
-			if ( it->isOperator(fd) )
-				it->removeOperator(fd);
-
-			if ( it->isEmpty() )
-				it = _channels.erase(it);
-			else
-				++it;
-		}
-	}
+		if ( client->getReadsDeferred() )
+			std::erase( shard.pendingReads, client );
+		Response::flushMessages( *client ); // Best effort delivery of the closing ERROR
+		shard.poller->remove( fd );
+		close( fd );
 
-	_disconnectEvent = false;
+		auto nickIt = _nicknames.find( client->getNickname() );
+		if ( nickIt != _nicknames.end() && nickIt->second == client->getHandle() )
+			_nicknames.erase( nickIt );
+		_clients.erase( fd );
+	}
 }
 
 /// Client messaging
 
-bool	Server::receiveClientMessage( int file_descriptor )
+/**
+ * @brief Reads what the client has sent and executes every complete message.
+ * The socket is drained until it would block, as edge-triggered backends only report new data once,
+ * or until the client's flood budget for the tick is used up. Its reads are then deferred and the
+ * rest is read on a later tick. Every read lands directly in the client's receive buffer.
+ * The buffer belongs to the shard, the state lock is only taken by each command as it executes.
+ *
+ * @param shard The shard owning the client.
+ * @param client The client whose socket is readable.
+ * @return false if the client should be disconnected, otherwise true
+ */
+bool	Server::receiveClientMessage( Shard& shard, Client& client )
 {
-	std::vector<char>	buffer( irc::MAX_IRC_MESSAGE_LENGTH + 1 );
+	ReceiveBuffer&	buffer = client.getReceiveBuffer();
 
-	ssize_t bytes = recv( file_descriptor, buffer.data(), irc::MAX_IRC_MESSAGE_LENGTH, 0 );
+	if ( client.getReadsDeferred() ) // Reported before its reads were dropped
+		return (true);
 
-	if ( bytes < 0 )
+	while ( true )
 	{
-		if ( errno != EAGAIN && errno != EWOULDBLOCK )
-		{
-			_clients[file_descriptor].setActive(false);
-			_disconnectEvent = true;
+		buffer.reserve();
+		ssize_t bytes = recv( client.getFd(), buffer.writeData(), buffer.writeSpace(), 0 );
+
+		if ( bytes < 0 && errno == EINTR )
+			continue ;
+		if ( bytes < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+			return (true);
+
+		if ( bytes <= 0 ) // Connection was closed or failed
+			return ( receiveCompletedMessage( shard, client, nullptr, bytes ) );
+		buffer.commit( bytes );
+		if ( !executeReceivedMessages( shard, client ) )
 			return (false);
-		}
+		if ( !client.getActive() )
+			return (true);
+
+		updateClientEvents( shard, client );
+		if ( !client.getReading() ) // The rest is read once its replies drain or on a later tick
+			return (true);
 	}
-	else if ( bytes == 0 )
+}
+
+/**
+ * @brief Handles the outcome of a read done by the event backend.
+ * The bytes are copied into the receive buffer and the complete messages are executed
+ * within the client's budget for the tick. A read still in flight when the client's reads
+ * were deferred may find the buffer full of waiting messages, those are then executed
+ * to make room, as the backend has already taken the bytes off the socket.
+ *
+ * @param shard The shard owning the client.
+ * @param client The client who sent the data.
+ * @param data The received bytes.
+ * @param bytes The received byte count, 0 on EOF and negative on failure.
+ * @return false if the client should be disconnected, otherwise true
+ */
+bool	Server::receiveCompletedMessage( Shard& shard, Client& client, const char* data, ssize_t bytes )
+{
+	if ( bytes <= 0 )
 	{
-		_clients[file_descriptor].setActive(false);
-		_disconnectEvent = true;
+		client.setActive(false);
+		setDisconnectEvent( client );
 		return (false);
 	}
-	else
+
+	if ( !client.getActive() )
+		return (false);
+
+	ReceiveBuffer&	buffer = client.getReceiveBuffer();
+	size_t			remaining = bytes;
+
+	while ( remaining > 0 && client.getActive() )
 	{
-		Client& client = _clients[file_descriptor];
+		buffer.reserve();
+		size_t length = std::min( remaining, buffer.writeSpace() );
 
-		if ( client.appendToReceiveBuffer( std::string(buffer.data(), bytes) ))
+		if ( length == 0 )
 		{
-			while ( client.isReceiveBufferComplete() )
-			{
-				std::string	message(client.extractLineFromReceive());
+			if ( !executeReceivedMessages( shard, client, false ) )
+				return (false);
+			continue ;
+		}
+		std::memcpy( buffer.writeData(), data, length );
+		buffer.commit( length );
+		data		+= length;
+		remaining	-= length;
+		if ( !executeReceivedMessages( shard, client ) )
+			return (false);
+	}
+	return (true);
+}
 
-				if constexpr (irc::EXTENDED_DEBUG_LOGGING)
-				{
-					irc::log_event("RECV", irc::LOG_DEBUG, message);
-				}
+/**
+ * @brief Executes the complete messages in the client's receive buffer.
+ * Messages are parsed straight from the buffer, only the incomplete tail stays behind.
+ * Every command is charged its flood cost, once the client spent irc::CLIENT_FLOOD_BUDGET
+ * in a tick its reads are deferred and the rest of the buffer waits for a later tick.
+ *
+ * @param budgeted false to run every complete message regardless of the budget.
+ * @return false if the incomplete tail outgrew its limit (client should disconnect), otherwise true
+ */
+bool	Server::executeReceivedMessages( Shard& shard, Client& client, bool budgeted )
+{
+	ReceiveBuffer&		buffer = client.getReceiveBuffer();
+	std::string_view	message;
 
-				Command	cmd = msgToCmd(message);
-				executeCommand(client, cmd);
-			}
-		}
-		else // Client attempted to overflow our buffer
+	while ( client.getActive() )
+	{
+		if ( budgeted && !client.hasFloodBudget( shard.tick ) )
 		{
-			Response::sendResponseCode( Response::ERR_INPUTTOOLONG, client, {} );
-			Response::sendServerError( client, client.getIpAddress(), "protocol violation");
+			if ( buffer.size() > 0 ) // Possibly only a partial line, it waits a tick either way
+				deferReads( shard, client );
+			return (true);
+		}
+		if ( !buffer.nextLine( message ) )
+			break ;
 
-			client.setActive(false);
-			_disconnectEvent = true;
-			return (false);
+		if constexpr (irc::EXTENDED_DEBUG_LOGGING)
+		{
+			irc::log_event("RECV", irc::LOG_DEBUG, message);
 		}
+
+		Command	cmd = msgToCmd(message);
+		client.spendFloodBudget( CommandHandler::floodCost( cmd.type ) );
+		executeCommand(client, cmd);
+		shard.scratch.release(); // Nothing the command built outlives it, a flood reuses the same buffer
+	}
+
+	if ( buffer.size() > static_cast<size_t>( irc::MAX_CLIENT_BUFFER_SIZE ) ) // Client attempted to overflow our buffer
+	{
+		irc::log_event( "PROTOCOL VIOLATION", irc::LOG_FAIL, "exceeded maximum buffer length limit" );
+		buffer.clear();
+		Response::sendResponseCode( Response::ERR_INPUTTOOLONG, client, {} );
+		Response::sendServerError( client, client.getIpAddress(), "protocol violation");
+
+		client.setQuitReason( "Input too long" );
+		client.setActive(false);
+		setDisconnectEvent( client );
+		return (false);
 	}
 	return (true);
 }
@@ -367,66 +643,250 @@ bool	Server::receiveClientMessage( int file_descriptor )
 /// Helper functions
 
 /**
- * @brief Adds POLLOUT flag to the pollfd events for clients with buffered outgoing messages.
+ * @brief Flushes every client of the shard which had replies queued since the last flush,
+ * one gathered write each. Clients whose socket could not take everything get POLLOUT
+ * and are finished when the socket drains.
  */
-void	Server::setClientsToPollout()
+void	Server::flushClients( Shard& shard )
 {
-	for ( auto& [fd, client] : _clients )
+	std::vector<int> clientsToFlush;
+
+	clientsToFlush.swap( shard.pendingSends );
+
+	for ( int fd : clientsToFlush )
 	{
-		if ( client.getPollout() )
-		{
-			for ( auto& element : _fds )
-			{
-				if ( element.fd == static_cast<int>(fd) )
-				{
-					element.events |= POLLOUT;
-					client.setPollout(false);
-					break ;
-				}
-			}
-		}
+		Client* found = _clients.find( fd );
+		if ( !found || found->getShard() != &shard )
+			continue ;
+
+		Client& client = *found;
+
+		client.setSendQueued(false);
+		// A client already waiting for POLLOUT or a write is only checked for backpressure
+		if ( client.getPollout() || Response::submitMessages( client ) )
+			updateClientEvents( shard, client );
 	}
+}
+
+/**
+ * @brief Consumes what a write started by the poller delivered and submits the rest of the queue.
+ * A failed write disconnects the client, one which would have blocked is tried again.
+ */
+void	Server::completeClientSend( Shard& shard, Client& client, int result )
+{
+	client.setSendInFlight(false);
+	if ( !client.getActive() ) // The queue was dropped when the client was marked
+		return ;
 
-	_polloutEvent = false;
+	if ( result < 0 && result != -EAGAIN && result != -EINTR )
+	{
+		client.clearSendBuffer();
+		client.setActive(false);
+		setDisconnectEvent( client );
+		if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
+			irc::log_event( "SEND", irc::LOG_FAIL, "client has disconnected" );
+		return ;
+	}
+	if ( result > 0 )
+		client.consumeSendBuffer( result );
+	if ( Response::submitMessages( client ) )
+		updateClientEvents( shard, client );
 }
 
-void	Server::executeCommand( Client& client, Command& cmd )
+/**
+ * @brief Queues the lines other shards forwarded to the shard's clients, which are then
+ * flushed with the shard's own replies. Lines for clients gone meanwhile are dropped.
+ */
+void	Server::deliverForwarded( Shard& shard )
 {
-	this->_commandHandler.handleCommand(client, cmd);
+	std::shared_lock<std::shared_mutex> lock( _stateMutex );
+
+	for ( const Shard::Delivery& delivery : shard.delivering )
+	{
+		Client* client = _clients.find( delivery.client );
+		if ( client && client->getShard() == &shard )
+			Response::sendMessage( *client, delivery.message, delivery.droppable );
+	}
+	shard.delivering.clear();
 }
 
-Channel*	Server::findChannel( const std::string& channelName )
+/**
+ * @brief Stops reading the client until the next tick, its flood budget for this one is used up.
+ * Nothing is lost, the kernel keeps what was not read yet.
+ */
+void	Server::deferReads( Shard& shard, Client& client )
 {
-	for (auto& channel : _channels)
+	if ( client.getReadsDeferred() )
+		return ;
+	client.setReadsDeferred(true);
+	shard.pendingReads.push_back( &client );
+}
+
+/**
+ * @brief Runs the messages deferred clients still have buffered, on a fresh budget.
+ * A client which gets through them is read again, one which does not stays deferred.
+ */
+void	Server::resumeDeferredReads( Shard& shard )
+{
+	shard.resumingReads.swap( shard.pendingReads );
+
+	for ( Client* client : shard.resumingReads )
 	{
-		if (channel.getName() == channelName)
-			return &channel;
+		client->setReadsDeferred(false);
+		if ( !client->getActive() )
+			continue ;
+		if ( executeReceivedMessages( shard, *client ) && client->getActive() )
+			updateClientEvents( shard, *client );
 	}
-	return nullptr;
+	shard.resumingReads.clear();
 }
 
-Client*	Server::findUser( const std::string& nickName )
+/**
+ * @brief Applies backpressure to the client and registers the events matching its state:
+ * POLLOUT while output is queued, POLLIN unless its reads are paused or deferred.
+ * A backend reports POLLIN again when it is registered anew while data is waiting.
+ *
+ * A client congested for longer than irc::SLOW_CONSUMER_TIMEOUT becomes a slow consumer and
+ * irc::SLOW_CONSUMER_ACTION is taken. It recovers once its queue drains to the low watermark.
+ * With PAUSE_READS the client is not read while above the high watermark, slow or not.
+ */
+void	Server::updateClientEvents( Shard& shard, Client& client )
+{
+	using irc::SlowConsumerAction;
+
+	if ( !client.getSlowConsumer() && client.hasCongestionExpired() )
+	{
+		irc::log_event("SEND QUEUE", irc::LOG_INFO, irc::concat(client.getNickname(), "@", client.getIpAddress(),
+			" is a slow consumer with ", std::to_string(client.getSendQueueSize()), " bytes queued"));
+		client.setSlowConsumer(true);
+		if constexpr ( irc::SLOW_CONSUMER_ACTION == SlowConsumerAction::DISCONNECT )
+		{
+			client.clearSendBuffer();
+			client.setQuitReason( "Max SendQ exceeded" );
+			client.setActive(false);
+			setDisconnectEvent( client );
+			return ;
+		}
+	}
+	else if ( client.getSlowConsumer() && client.getSendQueueSize() <= irc::SEND_QUEUE_LOW_WATERMARK )
+	{
+		irc::log_event("SEND QUEUE", irc::LOG_INFO, irc::concat(client.getNickname(), "@", client.getIpAddress(), " recovered"));
+		client.setSlowConsumer(false);
+	}
+
+	// Paused reads follow the watermarks directly, reading more would only grow the queue
+	size_t	queued	= client.getSendQueueSize();
+	bool	pollout	= client.hasPendingOutput() && !client.getSendInFlight();
+	bool	paused	= irc::SLOW_CONSUMER_ACTION == SlowConsumerAction::PAUSE_READS
+		&& queued > ( client.getReadsPaused() ? irc::SEND_QUEUE_LOW_WATERMARK : irc::SEND_QUEUE_HIGH_WATERMARK );
+
+	bool	reading	= !paused && !client.getReadsDeferred();
+
+	if ( pollout == client.getPollout() && reading == client.getReading() )
+	{
+		client.setReadsPaused( paused );
+		return ;
+	}
+
+	short events = ( reading ? POLLIN : 0 ) | ( pollout ? POLLOUT : 0 );
+	if ( shard.poller->modify( client.getFd(), events ) )
+	{
+		client.setPollout( pollout );
+		client.setReadsPaused( paused );
+		client.setReading( reading );
+	}
+}
+
+/**
+ * @brief Runs one command under the state lock. Commands which change nicknames, channels
+ * or registration hold it exclusively, the rest share it with the other shards.
+ */
+void	Server::executeCommand( Client& client, Command& cmd )
 {
-	for (auto& client : _clients)
+	if ( CommandHandler::isExclusive( cmd.type ) )
+	{
+		std::unique_lock<std::shared_mutex> lock( _stateMutex );
+		this->_commandHandler.handleCommand(client, cmd);
+	}
+	else
 	{
-		if (client.second.getNickname() == nickName)
-			return &client.second;
+		std::shared_lock<std::shared_mutex> lock( _stateMutex );
+		this->_commandHandler.handleCommand(client, cmd);
 	}
-	return nullptr;
 }
 
 /**
- * @brief Creates a new channel and adds it to the channels vector.
+ * @brief Finds a channel by name, names are compared following the advertised CASEMAPPING.
+ * The registry is node based, so the returned channel stays put until the channel is removed.
+ */
+Channel*	Server::findChannel( std::string_view channelName )
+{
+	auto it = _channels.find(channelName);
+
+	if (it == _channels.end())
+		return nullptr;
+	return &it->second;
+}
+
+/**
+ * @brief Finds a channel by its id, without hashing or comparing names.
+ */
+Channel*	Server::findChannel( ChannelId channelId )
+{
+	return channelId < _channelIds.size() ? _channelIds[channelId] : nullptr;
+}
+
+/**
+ * @brief Finds a client by nickname through the nickname index,
+ * names are compared following the advertised CASEMAPPING.
+ */
+Client*	Server::findUser( std::string_view nickName )
+{
+	auto it = _nicknames.find(nickName);
+
+	if (it == _nicknames.end())
+		return nullptr;
+	return _clients.find(it->second);
+}
+
+/**
+ * @brief Sets the nickname of the client and moves its nickname index entry.
+ * The caller has checked that no other client holds the nickname.
+ */
+void	Server::renameUser( Client& client, std::string_view nickName )
+{
+	auto it = _nicknames.find(client.getNickname());
+
+	if (it != _nicknames.end() && it->second == client.getHandle())
+		_nicknames.erase(it);
+	client.setNickname(nickName);
+	_nicknames[client.getNickname()] = client.getHandle();
+}
+
+/**
+ * @brief Creates a new channel, adds it to the channel registry and gives it an id.
  * Converts channelName to lowercase as an extra security measure.
  *
  * @param channelName Name of the new channel to be created.
  */
-void	Server::addChannel( const std::string channelName )
+void	Server::addChannel( std::string_view channelName )
 {
-	std::string lowercaseName = channelName;
+	std::pmr::string lowercaseName(channelName, &_objectPool);
 	std::transform(lowercaseName.begin(), lowercaseName.end(), lowercaseName.begin(), ::tolower);
 
-	_channels.emplace_back(lowercaseName);
+	if (_channels.find(lowercaseName) != _channels.end())
+		return ;
+
+	ChannelId id = static_cast<ChannelId>(_channelIds.size());
+
+	if (!_freeChannelIds.empty())
+	{
+		id = _freeChannelIds.back();
+		_freeChannelIds.pop_back();
+	}
+	else
+		_channelIds.push_back(nullptr);
+	_channelIds[id] = &_channels.try_emplace(lowercaseName, lowercaseName, id, &_objectPool).first->second;
 }
 
 /**
@@ -469,7 +929,7 @@ void	Server::fetchClientIp( Client& client )
 		else
 		{
 			if constexpr ( irc::EXTENDED_DEBUG_LOGGING )
-				irc::log_event("CONNECTION", irc::LOG_SUCCESS, "resolved IP: " + ip);
+				irc::log_event("CONNECTION", irc::LOG_SUCCESS, irc::concat("resolved IP: ", ip));
 			Response::sendServerNotice( client, irc::CLIENT_HOSTNAME_SUCCESS_MESSAGE );
 		}
 	}
@@ -478,78 +938,180 @@ void	Server::fetchClientIp( Client& client )
 }
 
 
-void	Server::removeChannel( const std::string& channelName)
+/**
+ * @brief Removes a channel from the registry and frees its id for the next new channel.
+ * Every member must have left the channel, and its invites are dropped from the invited
+ * clients, so no client still refers to the id.
+ */
+void	Server::removeChannel( std::string_view channelName )
 {
-	for (auto it = _channels.begin(); it != _channels.end(); it++)
+	auto it = _channels.find(channelName);
+
+	if (it == _channels.end())
+		return ;
+	// The id is reused by the next channel, invited clients must not keep pointing at it
+	for (const ClientHandle& invited : it->second.getInvited())
 	{
-		if (it->getName() == channelName)
-		{
-			_channels.erase(it);
-			return ;
-		}
+		if (Client* client = _clients.find(invited))
+			client->removeInvite(it->second.getId());
 	}
+	_channelIds[it->second.getId()] = nullptr;
+	_freeChannelIds.push_back(it->second.getId());
+	_channels.erase(it);
 }
 
 void	Server::broadcastShutdown( const std::string& reason )
 {
 	irc::log_event("SERVER", irc::LOG_DEBUG, "shutting down");
 
-	for ( const auto& [fd, client] : _clients )
+	for ( Client& client : _clients )
 	{
 		if ( client.getActive() )
-			Response::sendServerError(const_cast<Client&>(client), _serverHostname, "Server shutting down: " + reason );
+			Response::sendServerError( client, _serverHostname, "Server shutting down: " + reason );
 	}
+
+	// The event loops are stopping, so the queued messages are written right away.
+	// A client with a poller write still in flight keeps only what that write carried.
+	for ( Client& client : _clients )
+		Response::flushMessages( client );
 }
 
 
-const	std::unordered_map<unsigned, Client>&	Server::getClients() const	{ return _clients; }
-const	std::vector<Channel>					Server::getChannels() const	{ return _channels; }
-const	std::string&							Server::getPassword() const	{ return _password; }
+ClientTable&					Server::getClients()		{ return _clients; }
+const	Server::ChannelRegistry&	Server::getChannels() const	{ return _channels; }
+const	std::string&				Server::getPassword() const	{ return _password; }
 
 /**
- * @brief Used in timing out inactive client connections. Implemented before poll is called.
+ * @brief Runs the shard's client timers which came due. Only due clients are touched,
+ * the state lock is not taken at all on ticks without expired timers.
  */
-void	Server::checkTimeouts()
+void	Server::processTimers( Shard& shard )
 {
-	auto now		= std::chrono::steady_clock::now();
-	auto elapsed	= std::chrono::duration_cast<std::chrono::seconds>( now - _lastTimeoutCheck );
+	auto now = std::chrono::steady_clock::now();
 
-	if ( elapsed.count() < irc::TIMEOUT_INTERVAL )
-		return ;
+	shard.expiredTimers.clear();
+	shard.timers.advance( now, shard.expiredTimers );
 
-	_lastTimeoutCheck = now;
-	bool timeoutEvent = false;
-	for ( auto& [fd, client] : _clients )
+	if ( !shard.expiredTimers.empty() )
 	{
-		if ( client.hasRegistrationExpired() )
+		std::shared_lock<std::shared_mutex> lock( _stateMutex );
+
+		for ( const auto& timer : shard.expiredTimers )
 		{
-			irc::log_event("TIMEOUT", irc::LOG_INFO, client.getNickname() + "@" + client.getIpAddress() + " timed out");
-			Response::sendServerError( client, client.getIpAddress(), "Registration timeout");
-			client.setActive(false);
-			timeoutEvent = true;
-			continue ;
+			// The client may be gone, or its fd reused by a client with a newer timer
+			Client* client = _clients.find( timer.fd );
+			if ( !client || client->getShard() != &shard || client->getTimerId() != timer.id )
+				continue ;
+			runClientTimer( shard, *client, now );
 		}
-		if ( client.hasPingExpired() )
-		{
-			irc::log_event("TIMEOUT", irc::LOG_INFO, client.getNickname() + "@" + client.getIpAddress() + " timed out");
-			Response::sendServerError( client, client.getIpAddress(), "Ping timeout");
-			client.setActive(false);
-			timeoutEvent = true;
-			continue ;
-		}
-		if ( client.needsPing() )
+	}
+
+	if constexpr ( irc::ENABLE_QUEUE_METRICS )
+	{
+		if ( now - shard.lastMetricsReport >= std::chrono::seconds( irc::TIMEOUT_INTERVAL ) )
 		{
-			if constexpr ( irc:: EXTENDED_DEBUG_LOGGING )
-				irc::log_event("PING", irc::LOG_DEBUG, "sending ping to " + client.getIpAddress() );
-			Response::sendPing(client, _serverHostname);
-			client.setPingPending(true);
-			client.updateLastPing();
+			std::shared_lock<std::shared_mutex> lock( _stateMutex );
+			shard.lastMetricsReport = now;
+			reportQueueMetrics( shard );
 		}
 	}
-	if ( timeoutEvent )
+}
+
+/**
+ * @brief Replaces the client's timer with one expiring at the deadline. The caller must hold the state lock.
+ */
+void	Server::scheduleClientTimer( Shard& shard, Client& client, const std::chrono::steady_clock::time_point& deadline )
+{
+	client.setTimerId( ++shard.timerSequence );
+	shard.timers.schedule( client.getFd(), client.getTimerId(), deadline );
+}
+
+/**
+ * @brief Handles the client's next deadline and schedules the one after it.
+ * Each client has one timer, which is either its registration timeout, its ping expiry or its next keepalive.
+ * Keepalives are jittered, so clients which connected together are not pinged in one burst.
+ */
+void	Server::runClientTimer( Shard& shard, Client& client, const std::chrono::steady_clock::time_point& now )
+{
+	using std::chrono::seconds;
+
+	if ( !client.getActive() )
+		return ;
+
+	if ( client.hasPendingOutput() ) // Catches slow consumers which receive nothing new
+	{
+		updateClientEvents( shard, client );
+		if ( !client.getActive() )
+			return ;
+	}
+
+	if ( client.hasRegistrationExpired( now ) )
+		timeoutClient( client, "Registration timeout" );
+	else if ( !client.isAuthenticated() )
+		scheduleClientTimer( shard, client, client.getConnectionTime() + seconds( irc::CLIENT_REGISTRATION_TIMEOUT ) );
+	else if ( client.hasPingExpired( now ) )
+		timeoutClient( client, "Ping timeout" );
+	else if ( client.getPingPending() )
+		scheduleClientTimer( shard, client, client.getLastPing() + seconds( irc::CLIENT_PING_TIMEOUT ) );
+	else if ( client.needsPing( now ) )
+	{
+		if constexpr ( irc:: EXTENDED_DEBUG_LOGGING )
+			irc::log_event("PING", irc::LOG_DEBUG, irc::concat("sending ping to ", client.getIpAddress()) );
+		Response::sendPing(client, _serverHostname);
+		client.setPingPending(true);
+		client.setLastPing(now);
+		scheduleClientTimer( shard, client, now + seconds( irc::CLIENT_PING_TIMEOUT ) );
+	}
+	else
+		scheduleKeepalive( client );
+}
+
+/**
+ * @brief Schedules the client's next keepalive, a jittered ping interval after its last activity.
+ * Only the client's own shard calls it, from the client's timer or from a PONG the client sent.
+ */
+void	Server::scheduleKeepalive( Client& client )
+{
+	Shard&						shard = *client.getShard();
+	std::chrono::milliseconds	jitter( shard.random() % irc::CLIENT_PING_JITTER_MILLIS );
+
+	scheduleClientTimer( shard, client, client.getLastActivity() + std::chrono::seconds( irc::CLIENT_PING_INTERVAL ) + jitter );
+}
+
+void	Server::timeoutClient( Client& client, const std::string& reason )
+{
+	irc::log_event("TIMEOUT", irc::LOG_INFO, irc::concat(client.getNickname(), "@", client.getIpAddress(), " timed out"));
+	Response::sendServerError( client, client.getIpAddress(), reason );
+	client.setQuitReason( reason );
+	client.setActive(false);
+	setDisconnectEvent( client );
+}
+
+/**
+ * @brief Logs the send queue depth of the shard's clients. The caller must hold the state lock.
+ */
+void	Server::reportQueueMetrics( Shard& shard )
+{
+	size_t	queuedBytes		= 0;
+	size_t	peakBytes		= 0;
+	size_t	slowConsumers	= 0;
+	size_t	droppedMessages	= 0;
+
+	for ( const Client& client : _clients )
 	{
-		setDisconnectEvent(true);
+		if ( client.getShard() != &shard )
+			continue ;
+		queuedBytes		+= client.getSendQueueSize();
+		peakBytes		= std::max( peakBytes, client.getSendQueueSize() );
+		slowConsumers	+= client.getSlowConsumer();
+		droppedMessages	+= client.getDroppedMessages();
 	}
+
+	if ( queuedBytes > 0 || droppedMessages > 0 )
+		irc::log_event("METRICS", irc::LOG_INFO, "shard " + std::to_string(shard.index)
+			+ " send queues: " + std::to_string(queuedBytes) + " bytes queued, peak "
+			+ std::to_string(peakBytes) + " bytes, " + std::to_string(slowConsumers) + " slow consumer(s), "
+			+ std::to_string(droppedMessages) + " message(s) dropped");
 }
 
 /**
@@ -0,0 +1,81 @@
+#include "Shard.hpp"
+#include <sys/eventfd.h>
+
+/// Constructors and destructors
+
+Shard::Shard( unsigned shardIndex ) :
+	index( shardIndex ),
+	listener( -1 ),
+	wakeFd( eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) ),
+	poller( Poller::create() ),
+	inboxEvent( false ),
+	timerSequence( 0 ),
+	tick( 0 ),
+	random( std::random_device()() ),
+	lastMetricsReport( std::chrono::steady_clock::now() )
+{
+	if ( wakeFd < 0 )
+		throw ( std::runtime_error("Error: failed to create shard wakeup descriptor.") );
+
+	if ( !poller->add( wakeFd, POLLIN, nullptr ) )
+		throw ( std::runtime_error("Error: failed to register shard wakeup descriptor.") );
+}
+
+Shard::~Shard()
+{
+	if ( thread.joinable() )
+		thread.join();
+	if ( listener >= 0 )
+		close( listener );
+	if ( wakeFd >= 0 )
+		close( wakeFd );
+}
+
+
+/// Cross-shard signalling
+
+/**
+ * @brief Interrupts the shard's wait so it notices the flags raised by another shard.
+ */
+void	Shard::wake() noexcept
+{
+	uint64_t value = 1;
+	[[maybe_unused]] ssize_t written = write( wakeFd, &value, sizeof( value ) );
+}
+
+void	Shard::clearWake() noexcept
+{
+	uint64_t value;
+	[[maybe_unused]] ssize_t bytes = read( wakeFd, &value, sizeof( value ) );
+}
+
+/**
+ * @brief Queues a line for one of this shard's clients from another shard.
+ * Only the first line after a drain wakes the shard, the rest ride along.
+ */
+void	Shard::forward( ClientHandle client, const MessageBlock& message, bool droppable )
+{
+	{
+		std::lock_guard<std::mutex> lock( inboxMutex );
+		inbox.push_back( { client, message, droppable } );
+	}
+	if ( !inboxEvent.exchange( true ) )
+		wake();
+}
+
+/**
+ * @brief Moves the forwarded lines into delivering, for the owning shard to queue.
+ * The two vectors trade places, so neither reallocates once warmed up.
+ *
+ * @return false if nothing was forwarded since the last drain.
+ */
+bool	Shard::takeInbox()
+{
+	delivering.clear();
+	if ( !inboxEvent.exchange( false ) )
+		return ( false );
+
+	std::lock_guard<std::mutex> lock( inboxMutex );
+	delivering.swap( inbox );
+	return ( !delivering.empty() );
+}
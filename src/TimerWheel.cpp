@@ -0,0 +1,152 @@
+#include "TimerWheel.hpp"
+#include "constants.hpp"
+#include <algorithm>
+
+using milliseconds = std::chrono::milliseconds;
+
+/// Constructors and destructors
+
+TimerWheel::TimerWheel() :
+	_origin( clock::now() ),
+	_current( 0 ),
+	_size( 0 )
+{}
+
+
+/// Scheduling
+
+/**
+ * @brief Adds a timer. Deadlines are rounded up to the next tick, a deadline which
+ * has already passed expires on the next advance.
+ */
+void	TimerWheel::schedule( int fd, uint32_t id, const time_point& deadline )
+{
+	insert( { fd, id, std::max( toTicks( deadline ), _current + 1 ) } );
+	++_size;
+}
+
+/**
+ * @brief Moves the wheel forward to now, collecting every timer which expired on the way.
+ *
+ * @param now The current time.
+ * @param[out] expired Expired timers are appended here.
+ */
+void	TimerWheel::advance( const time_point& now, std::vector<Timer>& expired )
+{
+	uint64_t target = 0; // Only ticks which have fully elapsed
+
+	if ( now > _origin )
+		target = std::chrono::duration_cast<milliseconds>( now - _origin ).count() / irc::TIMER_RESOLUTION_MILLIS;
+
+	if ( _size == 0 ) // Nothing can expire, skip ahead
+	{
+		_current = std::max( _current, target );
+		return ;
+	}
+
+	while ( _current < target )
+	{
+		++_current;
+
+		// Crossing a slot boundary pulls the next slot of the level above down
+		for ( unsigned level = 1; level < LEVELS; ++level )
+		{
+			if ( ( _current & ( ( uint64_t(1) << ( SLOT_BITS * level ) ) - 1 ) ) != 0 )
+				break ;
+			cascade( level );
+		}
+
+		std::vector<Timer>& slot = _levels[0][_current & SLOT_MASK];
+
+		_size -= slot.size();
+		expired.insert( expired.end(), slot.begin(), slot.end() );
+		slot.clear();
+
+		if ( _size == 0 )
+		{
+			_current = target;
+			break ;
+		}
+	}
+}
+
+/**
+ * @brief Milliseconds until the wheel next has work to do, capped at maxMillis.
+ * For timers on the upper levels this is the time their slot is cascaded, which never comes after their expiry.
+ */
+int	TimerWheel::nextTimeout( const time_point& now, int maxMillis ) const
+{
+	if ( _size == 0 )
+		return ( maxMillis );
+
+	uint64_t next = UINT64_MAX;
+
+	for ( unsigned level = 0; level < LEVELS; ++level )
+	{
+		uint64_t position = _current >> ( SLOT_BITS * level );
+
+		for ( uint64_t step = 1; step <= SLOTS; ++step )
+		{
+			if ( _levels[level][( position + step ) & SLOT_MASK].empty() )
+				continue ;
+			next = std::min( next, ( position + step ) << ( SLOT_BITS * level ) );
+			break ;
+		}
+	}
+
+	auto deadline	= _origin + milliseconds( next * irc::TIMER_RESOLUTION_MILLIS );
+	auto remaining	= std::chrono::ceil<milliseconds>( deadline - now ).count();
+
+	return ( static_cast<int>( std::clamp<int64_t>( remaining, 0, maxMillis ) ) );
+}
+
+size_t	TimerWheel::size() const noexcept { return ( _size ); }
+
+
+/// Helpers
+
+uint64_t	TimerWheel::toTicks( const time_point& time ) const noexcept
+{
+	if ( time <= _origin )
+		return ( 0 );
+
+	auto elapsed = std::chrono::ceil<milliseconds>( time - _origin ).count();
+
+	return ( ( static_cast<uint64_t>( elapsed ) + irc::TIMER_RESOLUTION_MILLIS - 1 ) / irc::TIMER_RESOLUTION_MILLIS );
+}
+
+/**
+ * @brief Files the timer in the level covering its distance from the current tick.
+ * Timers beyond the range of the wheel wait in the last level and are refiled when it comes around.
+ */
+void	TimerWheel::insert( const Timer& timer )
+{
+	uint64_t	distance	= timer.expiry - _current;
+	unsigned	level		= 0;
+
+	while ( level + 1 < LEVELS && distance >= ( uint64_t(1) << ( SLOT_BITS * ( level + 1 ) ) ) )
+		++level;
+
+	uint64_t expiry = timer.expiry;
+	if ( distance >= ( uint64_t(1) << ( SLOT_BITS * LEVELS ) ) )
+		expiry = _current + ( uint64_t(1) << ( SLOT_BITS * LEVELS ) ) - 1;
+
+	_levels[level][( expiry >> ( SLOT_BITS * level ) ) & SLOT_MASK].push_back( timer );
+}
+
+/**
+ * @brief Refiles the timers of the level's current slot, which now lie within reach of the levels below.
+ */
+void	TimerWheel::cascade( unsigned level )
+{
+	std::vector<Timer> timers;
+
+	timers.swap( _levels[level][( _current >> ( SLOT_BITS * level ) ) & SLOT_MASK] );
+	for ( const Timer& timer : timers )
+	{
+		if ( timer.expiry <= _current ) // Due right now, level 0's current slot is drained next
+			_levels[0][_current & SLOT_MASK].push_back( timer );
+		else
+			insert( timer );
+	}
+}